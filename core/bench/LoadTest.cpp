@@ -0,0 +1,235 @@
+// End-to-end load test of the auth flow against `MockServer`, through `AuthClient` and a `MemoryTransport`.
+// Every auth makes the same requests as one in the mod: the message limit precheck, the challenge itself,
+// sending the solution to the bot and deleting that message afterwards.
+//
+// Prints a single JSON object with the auth latency percentiles and how many requests an auth takes:
+// {"auths":1000,"succeeded":1000,"failed":0,"concurrency":64,...,"p50_ms":1230.61,"p99_ms":1250.55,...,"requests_per_auth":7.00,...}
+//
+// Usage: argon-core-loadtest [--auths N] [--concurrency N] [--argon-latency-ms N] [--gd-latency-ms N] [--jitter-ms N]
+//                            [--error-rate F] [--poll-after-ms N] [--verify-delay-ms N] [--deadline-ms N]
+// Exits with 1 if any auth failed even though no errors were injected.
+
+#include "MockServer.hpp"
+#include <argon/core/AuthClient.hpp>
+#include <argon/core/GDEncoding.hpp>
+#include <argon/core/MemoryTransport.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace argon::core;
+using Clock = std::chrono::steady_clock;
+
+static constexpr auto MESSAGE_BODY = encodeGDConstant("This is a message sent to verify your account, it can be safely deleted.", "14251");
+
+struct Options {
+    size_t auths = 1000;
+    size_t concurrency = 64;
+    std::chrono::milliseconds verifyDeadline{30000};
+    MockServerOptions server;
+};
+
+static std::string gdForm(const Account& account, std::string_view extra) {
+    std::string out = "accountID=" + std::to_string(account.accountId);
+    out += "&gjp2=" + account.gjp2;
+    out += "&gameVersion=22&binaryVersion=45&secret=Wmfd2893gb7&";
+    out += extra;
+    return out;
+}
+
+static HttpResponse postGD(HttpTransport& transport, const Account& account, std::string_view endpoint, std::string body) {
+    return transport.send(HttpRequest {
+        .method = HttpMethod::Post,
+        .url = account.serverUrl + "/" + std::string{endpoint},
+        .body = std::move(body),
+        // GD servers expect form encoded bodies
+        .contentType = {},
+    });
+}
+
+// One worker, running auths one after another. Each has its own client, which remembers the message it sent.
+class Worker {
+public:
+    Worker(HttpTransport& transport, const Options& opts)
+        : m_transport(transport),
+          m_client(transport, [this](const Account& account, const Challenge& challenge, std::string_view text) {
+              return this->sendSolution(account, challenge, text);
+          }, AuthClientOptions {
+              .serverUrl = opts.server.argonUrl,
+              .reqMod = "dankmeme.argon-loadtest",
+              .verifyDeadline = opts.verifyDeadline,
+          }) {}
+
+    // Returns an error message on failure
+    std::optional<std::string> run(const Account& account) {
+        m_sentMessage.reset();
+
+        auto precheck = postGD(m_transport, account, "getGJMessages20.php", gdForm(account, "count=50&page=7&getSent=1"));
+        if (!precheck.ok() || precheck.body == "-1") {
+            return describeFailure(precheck, "message limit precheck");
+        }
+
+        auto result = m_client.authenticate(account);
+
+        // the verification message is deleted whether the auth worked or not, like the mod's cleanup queue does
+        if (m_sentMessage) {
+            postGD(m_transport, account, "deleteGJMessages20.php", gdForm(account, "isSender=1&messageID=" + std::to_string(*m_sentMessage)));
+        }
+
+        if (!result) {
+            return std::move(result).error();
+        }
+
+        return std::nullopt;
+    }
+
+private:
+    HttpTransport& m_transport;
+    AuthClient m_client;
+    std::optional<int> m_sentMessage;
+
+    std::optional<std::string> sendSolution(const Account& account, const Challenge& challenge, std::string_view text) {
+        std::string extra = "toAccountID=" + std::to_string(challenge.id) + "&subject=";
+        appendGDBase64(extra, text);
+        extra += "&body=";
+        extra += MESSAGE_BODY.view();
+
+        auto response = postGD(m_transport, account, "uploadGJMessage20.php", gdForm(account, extra));
+        if (!response.ok() || response.body.empty() || response.body.starts_with('-')) {
+            return describeFailure(response, "GD message");
+        }
+
+        m_sentMessage = std::atoi(response.body.c_str());
+        return std::nullopt;
+    }
+};
+
+static bool parseArgs(int argc, char** argv, Options& opts) {
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) return false;
+
+        std::string_view arg = argv[i];
+        const char* value = argv[++i];
+        char* end = nullptr;
+
+        if (arg == "--error-rate") {
+            opts.server.errorRate = std::strtod(value, &end);
+            if (*end != '\0' || opts.server.errorRate < 0.0 || opts.server.errorRate > 1.0) return false;
+            continue;
+        }
+
+        auto num = std::strtoull(value, &end, 10);
+        if (end == value || *end != '\0') return false;
+
+        if (arg == "--auths") opts.auths = num;
+        else if (arg == "--concurrency") opts.concurrency = num;
+        else if (arg == "--argon-latency-ms") opts.server.argonLatency = std::chrono::milliseconds(num);
+        else if (arg == "--gd-latency-ms") opts.server.gdLatency = std::chrono::milliseconds(num);
+        else if (arg == "--jitter-ms") opts.server.jitter = std::chrono::milliseconds(num);
+        else if (arg == "--poll-after-ms") opts.server.pollAfterMs = (uint32_t) num;
+        else if (arg == "--verify-delay-ms") opts.server.verifyDelay = std::chrono::milliseconds(num);
+        else if (arg == "--deadline-ms") opts.verifyDeadline = std::chrono::milliseconds(num);
+        else return false;
+    }
+
+    return opts.auths != 0 && opts.concurrency != 0;
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+
+    if (!parseArgs(argc, argv, opts)) {
+        std::fprintf(stderr,
+            "usage: %s [--auths N] [--concurrency N] [--argon-latency-ms N] [--gd-latency-ms N] [--jitter-ms N]\n"
+            "       [--error-rate F] [--poll-after-ms N] [--verify-delay-ms N] [--deadline-ms N]\n",
+            argv[0]
+        );
+        return 1;
+    }
+
+    MockServer server{opts.server};
+    MemoryTransport transport{[&](const HttpRequest& request) { return server.handle(request); }};
+
+    std::vector<uint64_t> latencies(opts.auths);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failed{0};
+
+    std::mutex errorsMutex;
+    std::map<std::string, size_t> errors;
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < std::min(opts.concurrency, opts.auths); t++) {
+        threads.emplace_back([&] {
+            Worker worker{transport, opts};
+
+            for (size_t i = next.fetch_add(1); i < opts.auths; i = next.fetch_add(1)) {
+                int accountId = (int) i + 1000;
+
+                Account account {
+                    .accountId = accountId,
+                    .userId = accountId + 7000000,
+                    .username = "player" + std::to_string(accountId),
+                    .gjp2 = "mockgjp2",
+                    .serverUrl = opts.server.gdUrl,
+                };
+
+                auto authStart = Clock::now();
+                auto error = worker.run(account);
+                latencies[i] = (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - authStart).count();
+
+                if (error) {
+                    failed.fetch_add(1);
+
+                    std::lock_guard lock{errorsMutex};
+                    errors[*error]++;
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::sort(latencies.begin(), latencies.end());
+
+    auto percentileMs = [&](size_t percent) {
+        return (double) latencies[std::min(latencies.size() - 1, latencies.size() * percent / 100)] / 1000.0;
+    };
+
+    uint64_t total = 0;
+    for (auto us : latencies) total += us;
+
+    auto stats = server.stats();
+    double auths = (double) opts.auths;
+
+    std::printf(
+        "{\"auths\":%zu,\"succeeded\":%zu,\"failed\":%zu,\"concurrency\":%zu,"
+        "\"mean_ms\":%.2f,\"p50_ms\":%.2f,\"p99_ms\":%.2f,\"max_ms\":%.2f,"
+        "\"auths_per_sec\":%.2f,\"requests_per_auth\":%.2f,\"argon_requests_per_auth\":%.2f,\"gd_requests_per_auth\":%.2f,"
+        "\"bytes_sent_per_auth\":%.1f,\"injected_errors\":%zu}\n",
+        opts.auths, opts.auths - failed.load(), failed.load(), std::min(opts.concurrency, opts.auths),
+        (double) total / auths / 1000.0, percentileMs(50), percentileMs(99), (double) latencies.back() / 1000.0,
+        auths / elapsed, (double) transport.requests() / auths,
+        (double) stats.argonRequests / auths, (double) stats.gdRequests / auths,
+        (double) transport.bytesSent() / auths, stats.injectedErrors
+    );
+
+    for (auto& [error, count] : errors) {
+        std::fprintf(stderr, "%zu auths failed: %s\n", count, error.c_str());
+    }
+
+    return failed.load() != 0 && opts.server.errorRate == 0.0 ? 1 : 0;
+}
@@ -0,0 +1,290 @@
+#include "MockServer.hpp"
+#include "Json.hpp"
+#include <argon/core/GDEncoding.hpp>
+#include <argon/core/Protocol.hpp>
+#include <algorithm>
+#include <thread>
+
+namespace argon::core {
+
+// Requests the mock server reads, named so they don't clash with the response fields in Protocol.cpp
+
+struct StartRequestFields {
+    std::optional<int64_t> accountId;
+    std::optional<int64_t> userId;
+    std::optional<std::string> username;
+};
+
+static constexpr JsonField<StartRequestFields> START_REQUEST_SCHEMA[] = {
+    jsonField<&StartRequestFields::accountId>("accountId"),
+    jsonField<&StartRequestFields::userId>("userId"),
+    jsonField<&StartRequestFields::username>("username"),
+};
+
+struct VerifyRequestFields {
+    std::optional<int64_t> challengeId;
+    std::optional<int64_t> accountId;
+    std::optional<std::string> solution;
+};
+
+static constexpr JsonField<VerifyRequestFields> VERIFY_REQUEST_SCHEMA[] = {
+    jsonField<&VerifyRequestFields::challengeId>("challengeId"),
+    jsonField<&VerifyRequestFields::accountId>("accountId"),
+    jsonField<&VerifyRequestFields::solution>("solution"),
+};
+
+template <typename T, size_t N>
+static std::optional<T> readBody(std::string_view body, const JsonField<T> (&schema)[N]) {
+    JsonReader reader{body};
+    T out{};
+
+    if (reader.peek() != JsonType::Object || !readJsonFields(reader, out, schema) || !reader.atEnd()) {
+        return std::nullopt;
+    }
+
+    return out;
+}
+
+static HttpResponse success(std::string_view data) {
+    std::string body = "{\"success\":true,\"data\":";
+    body += data;
+    body += '}';
+
+    return HttpResponse { .code = 200, .body = std::move(body), .error = {} };
+}
+
+static HttpResponse failure(int code, std::string_view error) {
+    std::string body = "{\"success\":false,\"error\":";
+    appendJsonString(body, error);
+    body += '}';
+
+    return HttpResponse { .code = code, .body = std::move(body), .error = {} };
+}
+
+static HttpResponse plain(std::string body) {
+    return HttpResponse { .code = 200, .body = std::move(body), .error = {} };
+}
+
+// Value of a field in a form encoded body, GD requests never need any unescaping
+static std::string_view formValue(std::string_view form, std::string_view key) {
+    while (!form.empty()) {
+        auto end = form.find('&');
+        auto pair = form.substr(0, end);
+
+        if (pair.size() > key.size() && pair.starts_with(key) && pair[key.size()] == '=') {
+            return pair.substr(key.size() + 1);
+        }
+
+        if (end == std::string_view::npos) break;
+        form.remove_prefix(end + 1);
+    }
+
+    return {};
+}
+
+static std::optional<int> formInt(std::string_view form, std::string_view key) {
+    auto value = formValue(form, key);
+    if (value.empty()) return std::nullopt;
+
+    int out = 0;
+    for (char c : value) {
+        if (c < '0' || c > '9') return std::nullopt;
+        out = out * 10 + (c - '0');
+    }
+
+    return out;
+}
+
+// Path of the request relative to `base`, if it is made to that server
+static std::optional<std::string_view> pathOf(std::string_view url, std::string_view base) {
+    if (url.size() <= base.size() || !url.starts_with(base) || url[base.size()] != '/') {
+        return std::nullopt;
+    }
+
+    return url.substr(base.size() + 1);
+}
+
+MockServer::MockServer(MockServerOptions options) : m_options(std::move(options)) {}
+
+HttpResponse MockServer::handle(const HttpRequest& request) {
+    // every endpoint the mod uses is POST only
+    if (request.method != HttpMethod::Post) {
+        return HttpResponse { .code = 405, .body = "Method not allowed", .error = {} };
+    }
+
+    if (auto path = pathOf(request.url, m_options.argonUrl)) {
+        m_argonRequests.fetch_add(1, std::memory_order::relaxed);
+
+        if (this->simulate(m_options.argonLatency)) {
+            return failure(500, "Injected server error");
+        }
+
+        if (*path == CHALLENGE_START_PATH) return this->challengeStart(request.body);
+        if (*path == CHALLENGE_VERIFY_PATH || *path == CHALLENGE_VERIFY_POLL_PATH) return this->challengeVerify(request.body);
+
+        return failure(404, "Not found");
+    }
+
+    if (auto path = pathOf(request.url, m_options.gdUrl)) {
+        m_gdRequests.fetch_add(1, std::memory_order::relaxed);
+
+        if (this->simulate(m_options.gdLatency)) {
+            return HttpResponse { .code = 500, .body = "error code: 500", .error = {} };
+        }
+
+        if (*path == "uploadGJMessage20.php") return this->uploadMessage(request.body);
+        if (*path == "getGJMessages20.php") return this->getMessages(request.body);
+        if (*path == "deleteGJMessages20.php") return this->deleteMessages(request.body);
+
+        return HttpResponse { .code = 404, .body = "-1", .error = {} };
+    }
+
+    return HttpResponse { .code = -1, .body = {}, .error = "Could not resolve host" };
+}
+
+MockServerStats MockServer::stats() const {
+    return MockServerStats {
+        .argonRequests = m_argonRequests.load(std::memory_order::relaxed),
+        .gdRequests = m_gdRequests.load(std::memory_order::relaxed),
+        .injectedErrors = m_injectedErrors.load(std::memory_order::relaxed),
+        .challengesStarted = m_challengesStarted.load(std::memory_order::relaxed),
+        .challengesVerified = m_challengesVerified.load(std::memory_order::relaxed),
+    };
+}
+
+bool MockServer::simulate(std::chrono::milliseconds latency) {
+    bool fail;
+    std::chrono::milliseconds delay;
+
+    {
+        std::lock_guard lock{m_mutex};
+
+        auto jitter = m_options.jitter.count();
+        auto offset = jitter > 0 ? (int64_t) (m_rng() % (uint64_t) (jitter * 2 + 1)) - jitter : 0;
+
+        delay = std::max(latency + std::chrono::milliseconds(offset), std::chrono::milliseconds::zero());
+        fail = std::uniform_real_distribution<double>{}(m_rng) < m_options.errorRate;
+    }
+
+    // the lock is not held while sleeping, so that concurrent requests actually overlap
+    if (delay.count() > 0) {
+        std::this_thread::sleep_for(delay);
+    }
+
+    if (fail) {
+        m_injectedErrors.fetch_add(1, std::memory_order::relaxed);
+    }
+
+    return fail;
+}
+
+HttpResponse MockServer::challengeStart(std::string_view body) {
+    auto fields = readBody(body, START_REQUEST_SCHEMA);
+    if (!fields || !fields->accountId || !fields->userId || !fields->username) {
+        return failure(400, "Invalid request body");
+    }
+
+    std::lock_guard lock{m_mutex};
+
+    uint32_t id = m_nextChallengeId++;
+    int challenge = (int) (m_rng() % 1000000000);
+
+    // the subject is all that the bot gets to see, so that is what the uploaded message is compared against
+    std::string subject;
+    appendGDBase64(subject, solutionText(solveChallenge(challenge)));
+
+    m_challenges.insert_or_assign(id, PendingChallenge {
+        .accountId = (int) *fields->accountId,
+        .challenge = challenge,
+        .subject = std::move(subject),
+    });
+    m_latestChallenge.insert_or_assign((int) *fields->accountId, id);
+    m_challengesStarted.fetch_add(1, std::memory_order::relaxed);
+
+    std::string data = "{\"method\":\"message\",\"id\":" + std::to_string(m_options.botAccountId);
+    data += ",\"challengeId\":" + std::to_string(id);
+    data += ",\"challenge\":" + std::to_string(challenge);
+    data += ",\"ident\":\"mock-" + std::to_string(id) + "\"}";
+
+    return success(data);
+}
+
+HttpResponse MockServer::challengeVerify(std::string_view body) {
+    auto fields = readBody(body, VERIFY_REQUEST_SCHEMA);
+    if (!fields || !fields->challengeId || !fields->accountId || !fields->solution) {
+        return failure(400, "Invalid request body");
+    }
+
+    std::lock_guard lock{m_mutex};
+
+    auto it = m_challenges.find((uint32_t) *fields->challengeId);
+    if (it == m_challenges.end() || it->second.accountId != *fields->accountId) {
+        return failure(404, "Challenge not found");
+    }
+
+    auto& pending = it->second;
+    if (*fields->solution != solveChallenge(pending.challenge)) {
+        return failure(400, "Invalid solution");
+    }
+
+    if (!pending.sentAt || Clock::now() < *pending.sentAt + m_options.verifyDelay) {
+        return success("{\"verified\":false,\"pollAfter\":" + std::to_string(m_options.pollAfterMs) + "}");
+    }
+
+    auto token = "mock." + std::to_string(pending.accountId) + "." + std::to_string(it->first);
+
+    if (auto latest = m_latestChallenge.find(pending.accountId); latest != m_latestChallenge.end() && latest->second == it->first) {
+        m_latestChallenge.erase(latest);
+    }
+
+    m_challenges.erase(it);
+    m_challengesVerified.fetch_add(1, std::memory_order::relaxed);
+
+    std::string data = "{\"verified\":true,\"authtoken\":";
+    appendJsonString(data, token);
+    data += ",\"commentId\":0,\"expiresIn\":2592000}";
+
+    return success(data);
+}
+
+HttpResponse MockServer::uploadMessage(std::string_view form) {
+    auto accountId = formInt(form, "accountID");
+    auto target = formInt(form, "toAccountID");
+    auto subject = formValue(form, "subject");
+
+    if (!accountId || !target || formValue(form, "gjp2").empty() || subject.empty()) {
+        return plain("-1");
+    }
+
+    std::lock_guard lock{m_mutex};
+
+    // a message that doesn't solve anything is still a valid message, the challenge just never gets verified
+    if (auto latest = m_latestChallenge.find(*accountId); latest != m_latestChallenge.end() && *target == m_options.botAccountId) {
+        auto& pending = m_challenges.at(latest->second);
+
+        if (pending.subject == subject && !pending.sentAt) {
+            pending.sentAt = Clock::now();
+        }
+    }
+
+    return plain(std::to_string(m_nextMessageId++));
+}
+
+HttpResponse MockServer::getMessages(std::string_view form) {
+    if (!formInt(form, "accountID") || formValue(form, "gjp2").empty()) {
+        return plain("-1");
+    }
+
+    // no sent messages, so never at the message limit
+    return plain("-2");
+}
+
+HttpResponse MockServer::deleteMessages(std::string_view form) {
+    if (!formInt(form, "accountID") || formValue(form, "gjp2").empty()) {
+        return plain("-1");
+    }
+
+    return plain("1");
+}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <argon/core/Transport.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace argon::core {
+
+struct MockServerOptions {
+    // Base URLs of the simulated servers, without a trailing slash
+    std::string argonUrl = "http://argon.mock";
+    std::string gdUrl = "http://gd.mock";
+    // Every request takes this long, give or take up to `jitter`
+    std::chrono::milliseconds argonLatency{20};
+    std::chrono::milliseconds gdLatency{50};
+    std::chrono::milliseconds jitter{5};
+    // Fraction of requests that fail with a 500 instead of being handled
+    double errorRate = 0.0;
+    // Sent as `pollAfter` while the solution is not verified yet
+    uint32_t pollAfterMs = 500;
+    // How long it takes the Argon server to notice the solution after it was sent to the bot
+    std::chrono::milliseconds verifyDelay{1000};
+    // Account ID of the bot that solutions have to be messaged to
+    int botAccountId = 12345;
+};
+
+struct MockServerStats {
+    size_t argonRequests = 0;
+    size_t gdRequests = 0;
+    size_t injectedErrors = 0;
+    size_t challengesStarted = 0;
+    size_t challengesVerified = 0;
+};
+
+// In-process stand-in for an Argon server and the GD server it verifies accounts on, for driving `AuthClient`
+// through a `MemoryTransport`. Implements the challenge endpoints and the GD message endpoints used by the mod,
+// and only checks as much as is needed to tell that the client went through the whole flow correctly.
+class MockServer {
+public:
+    explicit MockServer(MockServerOptions options = {});
+
+    // Answers a request to either server, can be used directly as the handler of a `MemoryTransport`. Thread-safe.
+    HttpResponse handle(const HttpRequest& request);
+
+    MockServerStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingChallenge {
+        int accountId;
+        int challenge;
+        // the GD encoded message subject that delivers the right solution
+        std::string subject;
+        // when the solution was messaged to the bot
+        std::optional<Clock::time_point> sentAt{};
+    };
+
+    MockServerOptions m_options;
+
+    std::mutex m_mutex;
+    std::unordered_map<uint32_t, PendingChallenge> m_challenges;
+    // the last challenge started by every account, the only one a message can solve
+    std::unordered_map<int, uint32_t> m_latestChallenge;
+    uint32_t m_nextChallengeId = 1;
+    int m_nextMessageId = 1;
+    std::mt19937_64 m_rng{0x6d6f636b};
+
+    std::atomic<size_t> m_argonRequests{0};
+    std::atomic<size_t> m_gdRequests{0};
+    std::atomic<size_t> m_injectedErrors{0};
+    std::atomic<size_t> m_challengesStarted{0};
+    std::atomic<size_t> m_challengesVerified{0};
+
+    // Waits out the simulated latency, returns whether the request should fail
+    bool simulate(std::chrono::milliseconds latency);
+
+    HttpResponse challengeStart(std::string_view body);
+    HttpResponse challengeVerify(std::string_view body);
+    HttpResponse uploadMessage(std::string_view form);
+    HttpResponse getMessages(std::string_view form);
+    HttpResponse deleteMessages(std::string_view form);
+};
+
+}
@@ -0,0 +1,378 @@
+// Micro-benchmarks for the token storage at 10 to 100k stored tokens: the in-memory index every lookup goes through,
+// the binary token file it is loaded from and saved to, and lookups from several threads behind one mutex,
+// the same way the mod serializes them with `acquireConfigLock`.
+//
+// Prints one JSON object per line, so results can be collected and compared between releases:
+// {"op":"lookup","records":1000,"threads":1,"iterations":10000,"mean_ns":41,"p50_ns":38,"p99_ns":90,"allocs_per_op":0.00}
+//
+// Usage: argon-core-bench [--max-records N] [--iterations N]
+// Numbers are only meaningful in a release build.
+
+#include <argon/core/BinaryTokenStore.hpp>
+#include <argon/core/TokenIndex.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace argon::core;
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<uint64_t> allocations{0};
+
+// every allocation in the process goes through here, the array and nothrow forms call these too
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order::relaxed);
+
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+static constexpr std::string_view SERVERS[] = {
+    "https://argon.globed.dev",
+    "https://argon.example.com",
+    "https://auth.example.org",
+    "http://localhost:4340",
+};
+
+static constexpr size_t RECORD_COUNTS[] = { 10, 100, 1000, 10000, 100000 };
+static constexpr size_t THREAD_COUNTS[] = { 1, 2, 4, 8 };
+
+struct Options {
+    size_t maxRecords = 100000;
+    // for operations that don't get slower with more records
+    size_t iterations = 10000;
+};
+
+// Every account has a token on each server, like a player that plays on several servers
+static std::vector<StoredToken> makeTokens(size_t count, std::mt19937_64& rng) {
+    std::vector<StoredToken> out;
+    out.reserve(count);
+
+    for (size_t i = 0; i < count; i++) {
+        int accountId = (int) (i / std::size(SERVERS)) + 1;
+
+        out.push_back(StoredToken {
+            .url = std::string{SERVERS[i % std::size(SERVERS)]},
+            .accountId = accountId,
+            .userId = accountId + 7000000,
+            .username = "player" + std::to_string(accountId),
+            .ident = std::to_string(rng()),
+            .token = std::to_string(rng()) + "." + std::to_string(rng()) + "." + std::to_string(rng()),
+            .issuedAt = 1700000000,
+            .expiresAt = 1700000000 + 86400 * 30,
+        });
+    }
+
+    return out;
+}
+
+static TokenIndex makeIndex(const std::vector<StoredToken>& tokens) {
+    TokenIndex index;
+    index.assign(tokens);
+    return index;
+}
+
+// Timings of a single operation, allocations are only counted while the operation runs
+class Samples {
+public:
+    explicit Samples(size_t expected) {
+        m_ns.reserve(expected);
+    }
+
+    template <typename F>
+    void measure(F&& op) {
+        auto allocsBefore = allocations.load(std::memory_order::relaxed);
+        auto start = Clock::now();
+
+        op();
+
+        auto end = Clock::now();
+        m_allocations += allocations.load(std::memory_order::relaxed) - allocsBefore;
+        this->add(end - start);
+    }
+
+    void add(Clock::duration time) {
+        m_ns.push_back((uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+    }
+
+    void merge(const Samples& other) {
+        m_ns.insert(m_ns.end(), other.m_ns.begin(), other.m_ns.end());
+        m_allocations += other.m_allocations;
+    }
+
+    void report(std::string_view op, size_t records, size_t threads = 1) {
+        if (m_ns.empty()) return;
+
+        std::sort(m_ns.begin(), m_ns.end());
+
+        uint64_t total = 0;
+        for (auto ns : m_ns) total += ns;
+
+        auto at = [&](size_t percent) {
+            return m_ns[std::min(m_ns.size() - 1, m_ns.size() * percent / 100)];
+        };
+
+        std::printf(
+            "{\"op\":\"%.*s\",\"records\":%zu,\"threads\":%zu,\"iterations\":%zu,\"mean_ns\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu,\"allocs_per_op\":%.2f}\n",
+            (int) op.size(), op.data(), records, threads, m_ns.size(),
+            (unsigned long long) (total / m_ns.size()),
+            (unsigned long long) at(50),
+            (unsigned long long) at(99),
+            (double) m_allocations / (double) m_ns.size()
+        );
+        std::fflush(stdout);
+    }
+
+private:
+    std::vector<uint64_t> m_ns;
+    uint64_t m_allocations = 0;
+};
+
+// Operations that copy or rewrite the whole index are repeated less the bigger it is
+static size_t heavyIterations(size_t records) {
+    return std::clamp<size_t>(1000000 / records, 20, 1000);
+}
+
+// keeps the compiler from optimizing away lookups whose result is unused
+static volatile size_t sink = 0;
+
+static void benchLookup(const Options& opts, const std::vector<StoredToken>& tokens, std::mt19937_64& rng) {
+    auto index = makeIndex(tokens);
+    Samples hits{opts.iterations}, misses{opts.iterations};
+
+    for (size_t i = 0; i < opts.iterations; i++) {
+        auto& key = tokens[rng() % tokens.size()];
+        hits.measure([&] { sink = sink + (index.find(key.url, key.accountId, key.userId) != nullptr); });
+    }
+
+    for (size_t i = 0; i < opts.iterations; i++) {
+        auto& key = tokens[rng() % tokens.size()];
+        // right account, but a server it has no token for
+        misses.measure([&] { sink = sink + (index.find("https://unknown.example.com", key.accountId, key.userId) != nullptr); });
+    }
+
+    hits.report("lookup", tokens.size());
+    misses.report("lookup_miss", tokens.size());
+}
+
+// Inserting every token one by one into an empty index, like storing tokens for new accounts
+static void benchInsert(const Options& opts, const std::vector<StoredToken>& tokens) {
+    size_t rounds = std::max<size_t>(1, opts.iterations / tokens.size());
+    Samples samples{rounds * tokens.size()};
+
+    for (size_t round = 0; round < rounds; round++) {
+        auto pending = tokens;
+        TokenIndex index;
+
+        for (auto& token : pending) {
+            samples.measure([&] { index.upsert(std::move(token)); });
+        }
+    }
+
+    samples.report("insert", tokens.size());
+}
+
+// Replacing the token of an account that already has one, like a refresh
+static void benchUpdate(const Options& opts, const std::vector<StoredToken>& tokens, std::mt19937_64& rng) {
+    auto index = makeIndex(tokens);
+
+    std::vector<StoredToken> updates;
+    updates.reserve(opts.iterations);
+
+    for (size_t i = 0; i < opts.iterations; i++) {
+        auto& update = updates.emplace_back(tokens[rng() % tokens.size()]);
+        update.token = std::to_string(rng()) + "." + std::to_string(rng()) + "." + std::to_string(rng());
+    }
+
+    Samples samples{opts.iterations};
+
+    for (auto& update : updates) {
+        samples.measure([&] { index.upsert(std::move(update)); });
+    }
+
+    samples.report("update", tokens.size());
+}
+
+// Removing the tokens of one account on one server, and of every account on one server
+static void benchClear(const std::vector<StoredToken>& tokens, std::mt19937_64& rng) {
+    size_t iterations = heavyIterations(tokens.size());
+    Samples account{iterations}, server{iterations};
+
+    for (size_t i = 0; i < iterations; i++) {
+        auto index = makeIndex(tokens);
+        auto& key = tokens[rng() % tokens.size()];
+
+        account.measure([&] { sink = sink + index.eraseAccount(key.accountId, key.url); });
+    }
+
+    for (size_t i = 0; i < iterations; i++) {
+        auto index = makeIndex(tokens);
+        server.measure([&] { sink = sink + index.eraseServer(SERVERS[i % std::size(SERVERS)]); });
+    }
+
+    account.report("clear_account", tokens.size());
+    server.report("clear_server", tokens.size());
+}
+
+// Writing the binary token file and reading it back into an index, the way the mod loads it when it changed on disk
+static void benchFile(const std::vector<StoredToken>& tokens) {
+    auto path = std::filesystem::temp_directory_path() / "argon-core-bench.bin";
+    size_t iterations = heavyIterations(tokens.size());
+    Samples save{iterations}, load{iterations};
+
+    for (size_t i = 0; i < iterations; i++) {
+        save.measure([&] {
+            auto data = encodeBinaryStore(i, tokens, {});
+            std::ofstream file{path, std::ios::binary | std::ios::trunc};
+            file.write(reinterpret_cast<const char*>(data.data()), (std::streamsize) data.size());
+        });
+    }
+
+    for (size_t i = 0; i < iterations; i++) {
+        TokenIndex index;
+
+        load.measure([&] {
+            std::ifstream file{path, std::ios::binary};
+            std::vector<uint8_t> data(std::filesystem::file_size(path));
+            file.read(reinterpret_cast<char*>(data.data()), (std::streamsize) data.size());
+
+            auto contents = decodeBinaryStore(data);
+            if (!contents) {
+                std::fprintf(stderr, "failed to decode the binary token file: %s\n", contents.error().c_str());
+                std::exit(1);
+            }
+
+            index.assign(std::move(contents->tokens));
+        });
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    save.report("save_file", tokens.size());
+    load.report("load_file", tokens.size());
+}
+
+// Lookups from several threads at once, each one holding the lock for the duration of the lookup.
+// `lock_wait` is only the time spent waiting for the lock, `locked_lookup` includes the lookup itself.
+static void benchContention(const Options& opts, const std::vector<StoredToken>& tokens) {
+    auto index = makeIndex(tokens);
+
+    for (size_t threads : THREAD_COUNTS) {
+        std::mutex lock;
+        std::atomic<size_t> ready{0};
+        std::vector<Samples> waits, totals;
+
+        for (size_t t = 0; t < threads; t++) {
+            waits.emplace_back(opts.iterations);
+            totals.emplace_back(opts.iterations);
+        }
+
+        std::vector<std::thread> workers;
+
+        for (size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                std::mt19937_64 rng{t + 1};
+
+                // start all at once, so the threads actually compete for the lock
+                ready.fetch_add(1);
+                while (ready.load() != threads) {}
+
+                for (size_t i = 0; i < opts.iterations; i++) {
+                    auto& key = tokens[rng() % tokens.size()];
+                    auto start = Clock::now();
+
+                    std::lock_guard guard{lock};
+                    waits[t].add(Clock::now() - start);
+
+                    sink = sink + (index.find(key.url, key.accountId, key.userId) != nullptr);
+                    totals[t].add(Clock::now() - start);
+                }
+            });
+        }
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        for (size_t t = 1; t < threads; t++) {
+            waits[0].merge(waits[t]);
+            totals[0].merge(totals[t]);
+        }
+
+        waits[0].report("lock_wait", tokens.size(), threads);
+        totals[0].report("locked_lookup", tokens.size(), threads);
+    }
+}
+
+static bool parseCount(const char* arg, size_t& out) {
+    char* end = nullptr;
+    auto value = std::strtoull(arg, &end, 10);
+
+    if (end == arg || *end != '\0' || value == 0) {
+        return false;
+    }
+
+    out = (size_t) value;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+
+    for (int i = 1; i < argc; i++) {
+        bool ok = false;
+
+        if (std::strcmp(argv[i], "--max-records") == 0 && i + 1 < argc) {
+            ok = parseCount(argv[++i], opts.maxRecords);
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            ok = parseCount(argv[++i], opts.iterations);
+        }
+
+        if (!ok) {
+            std::fprintf(stderr, "usage: %s [--max-records N] [--iterations N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // fixed seed, so every run measures the same data
+    std::mt19937_64 rng{0x61726730};
+
+    for (size_t records : RECORD_COUNTS) {
+        if (records > opts.maxRecords) break;
+
+        auto tokens = makeTokens(records, rng);
+
+        benchLookup(opts, tokens, rng);
+        benchInsert(opts, tokens);
+        benchUpdate(opts, tokens, rng);
+        benchClear(tokens, rng);
+        benchFile(tokens);
+        benchContention(opts, tokens);
+    }
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Protocol.hpp"
+#include <chrono>
+#include <functional>
+#include <optional>
+
+namespace argon::core {
+
+struct AuthClientOptions {
+    std::string serverUrl = "https://argon.globed.dev";
+    // Sent to the server as `reqMod`, identifies who is requesting the token
+    std::string reqMod;
+    std::chrono::milliseconds timeout{10000};
+    // How long to wait for the solution to be verified in total
+    std::chrono::milliseconds verifyDeadline{30000};
+};
+
+// Delivers the solution to the GD server, as a message or a level comment depending on `challenge.method`.
+// Returns an error message on failure.
+using SolutionSubmitter = std::function<std::optional<std::string>(const Account& account, const Challenge& challenge, std::string_view text)>;
+
+// Runs the whole challenge flow for one account with blocking requests. This is the same flow as the one used by the Geode mod,
+// minus retries, diagnostics and GD specific fallbacks. Thread-safe, as long as the transport and the submitter are.
+class AuthClient {
+public:
+    AuthClient(HttpTransport& transport, SolutionSubmitter submitter, AuthClientOptions options = {});
+
+    Expected<Verification> authenticate(const Account& account, std::string_view preferredMethod = "message", bool forceStrong = false);
+
+private:
+    HttpTransport& m_transport;
+    SolutionSubmitter m_submitter;
+    AuthClientOptions m_options;
+
+    HttpResponse post(std::string_view path, std::string body);
+};
+
+}
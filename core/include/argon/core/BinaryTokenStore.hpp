@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Expected.hpp"
+#include "TokenIndex.hpp"
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+#include <stdint.h>
+
+namespace argon::core {
+
+// Compact binary alternative to the JSON data file. It is only another encoding of the same data:
+// the whole file is decoded into a TokenIndex when it's loaded, lookups never read from it directly.
+// What it saves over JSON is the parsing, every field has a fixed size and position.
+//
+// Everything is little-endian and 4-byte aligned:
+//
+// [BinaryStoreHeader]
+// [urlCount * BinaryStoreString]     interned server URLs, shared by every record that uses them
+// [recordCount * BinaryStoreRecord]  fixed-size records
+// [cleanupCount * BinaryStoreCleanup] pending message and comment deletions
+// [stringsSize bytes]                string pool, referenced by offset and length
+//
+// The header also records the stamp of the JSON file at the time this one was written.
+// Older versions of Argon only know about the JSON file, so if its stamp no longer matches,
+// the binary file is outdated and must be ignored.
+
+struct BinaryStoreHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t headerSize;
+    uint64_t generation;
+    uint64_t jsonSize;
+    int64_t jsonMtime;
+    uint32_t urlCount;
+    uint32_t recordCount;
+    uint32_t recordSize;
+    uint32_t stringsSize;
+    uint32_t cleanupCount;
+    uint32_t cleanupSize;
+};
+
+struct BinaryStoreString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct BinaryStoreRecord {
+    uint32_t urlIndex;
+    int32_t accountId;
+    int32_t userId;
+    uint32_t reserved;
+    BinaryStoreString username;
+    BinaryStoreString ident;
+    BinaryStoreString token;
+    int64_t issuedAt;
+    int64_t expiresAt;
+    int64_t validatedAt;
+};
+
+struct BinaryStoreCleanup {
+    uint32_t urlIndex;
+    int32_t accountId;
+    int32_t id;
+    int32_t levelId;
+    uint8_t kind;
+    uint8_t reserved[3];
+    uint32_t attempts;
+    int64_t notBefore;
+};
+
+static_assert(sizeof(BinaryStoreHeader) == 56);
+static_assert(sizeof(BinaryStoreString) == 8);
+static_assert(sizeof(BinaryStoreRecord) == 64);
+static_assert(sizeof(BinaryStoreCleanup) == 32);
+
+struct BinaryStoreContents {
+    uint64_t generation = 0;
+    uint64_t jsonSize = 0;
+    int64_t jsonMtime = 0;
+    std::vector<StoredToken> tokens;
+    std::vector<PendingCleanup> cleanups;
+};
+
+// Offset and size of the JSON stamp in the header, it is patched in after the JSON file has been written
+constexpr size_t BINARY_STORE_STAMP_OFFSET = offsetof(BinaryStoreHeader, jsonSize);
+constexpr size_t BINARY_STORE_STAMP_SIZE = sizeof(uint64_t) + sizeof(int64_t);
+
+std::vector<uint8_t> encodeBinaryStore(uint64_t generation, const std::vector<StoredToken>& tokens, const std::vector<PendingCleanup>& cleanups);
+Expected<BinaryStoreContents> decodeBinaryStore(std::span<const uint8_t> data);
+
+// Encodes the stamp the way it is stored in the header
+std::array<uint8_t, BINARY_STORE_STAMP_SIZE> encodeBinaryStoreStamp(const FileStamp& stamp);
+bool binaryStoreMatches(const BinaryStoreContents& contents, const FileStamp& jsonStamp);
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <variant>
+
+namespace argon::core {
+
+// Either a value or an error message. Follows the interface of `std::expected`, which is not available in C++20,
+// so that the core does not need to depend on Geode's `Result`.
+template <typename T>
+class Expected {
+public:
+    Expected(T value) : m_data(std::in_place_index<0>, std::move(value)) {}
+
+    static Expected fail(std::string error) {
+        return Expected{std::in_place_index<1>, std::move(error)};
+    }
+
+    bool has_value() const {
+        return m_data.index() == 0;
+    }
+
+    explicit operator bool() const {
+        return this->has_value();
+    }
+
+    T& value() & { return std::get<0>(m_data); }
+    const T& value() const& { return std::get<0>(m_data); }
+    T&& value() && { return std::get<0>(std::move(m_data)); }
+
+    T& operator*() & { return this->value(); }
+    const T& operator*() const& { return this->value(); }
+    T&& operator*() && { return std::move(*this).value(); }
+
+    T* operator->() { return &this->value(); }
+    const T* operator->() const { return &this->value(); }
+
+    const std::string& error() const& { return std::get<1>(m_data); }
+    std::string&& error() && { return std::get<1>(std::move(m_data)); }
+
+private:
+    std::variant<T, std::string> m_data;
+
+    template <size_t I, typename U>
+    Expected(std::in_place_index_t<I> tag, U&& value) : m_data(tag, std::forward<U>(value)) {}
+};
+
+}
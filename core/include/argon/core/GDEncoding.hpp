@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <stddef.h>
+#include <stdint.h>
+
+// GD's encoding for message bodies, comments and checksums: the data is XORed with a repeating key
+// (or left as is if there is no key) and then encoded with URL-safe base64, keeping the padding.
+
+namespace argon::core {
+
+inline constexpr char GD_BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+constexpr size_t gdBase64Size(size_t size) {
+    return (size + 2) / 3 * 4;
+}
+
+namespace detail {
+    template <bool Xor>
+    constexpr size_t encodeGDBase64(char* out, std::string_view data, std::string_view key) {
+        size_t k = 0;
+
+        auto at = [&](size_t i) -> uint32_t {
+            auto byte = (uint8_t) data[i];
+
+            if constexpr (Xor) {
+                byte ^= (uint8_t) key[k];
+                if (++k == key.size()) k = 0;
+            }
+
+            return byte;
+        };
+
+        auto put = [&](char* dst, uint32_t group) {
+            dst[0] = GD_BASE64_ALPHABET[group >> 18];
+            dst[1] = GD_BASE64_ALPHABET[(group >> 12) & 63];
+            dst[2] = GD_BASE64_ALPHABET[(group >> 6) & 63];
+            dst[3] = GD_BASE64_ALPHABET[group & 63];
+        };
+
+        size_t full = data.size() / 3 * 3;
+        char* dst = out;
+
+        for (size_t i = 0; i < full; i += 3) {
+            // separate statements, the key index has to advance in order
+            uint32_t group = at(i) << 16;
+            group |= at(i + 1) << 8;
+            group |= at(i + 2);
+
+            put(dst, group);
+            dst += 4;
+        }
+
+        size_t rest = data.size() - full;
+        if (rest != 0) {
+            uint32_t group = at(full) << 16;
+            if (rest == 2) {
+                group |= at(full + 1) << 8;
+            }
+
+            put(dst, group);
+            dst[3] = '=';
+            if (rest == 1) dst[2] = '=';
+
+            dst += 4;
+        }
+
+        return (size_t) (dst - out);
+    }
+}
+
+// Writes exactly `gdBase64Size(data.size())` characters to `out`, returns that amount. An empty key means no XOR.
+constexpr size_t encodeGDBase64(char* out, std::string_view data, std::string_view key = {}) {
+    if (key.empty()) {
+        return detail::encodeGDBase64<false>(out, data, key);
+    }
+
+    return detail::encodeGDBase64<true>(out, data, key);
+}
+
+// Appends the encoded data to `out`, without any temporary buffers
+void appendGDBase64(std::string& out, std::string_view data, std::string_view key = {});
+
+template <size_t N>
+struct EncodedConstant {
+    std::array<char, gdBase64Size(N)> data{};
+
+    constexpr std::string_view view() const {
+        return std::string_view{data.data(), data.size()};
+    }
+};
+
+// Encodes a string literal at compile time, for parts of requests that never change
+template <size_t N>
+consteval EncodedConstant<N - 1> encodeGDConstant(const char (&data)[N], std::string_view key = {}) {
+    EncodedConstant<N - 1> out;
+    encodeGDBase64(out.data.data(), std::string_view{data, N - 1}, key);
+    return out;
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Transport.hpp"
+#include <atomic>
+#include <functional>
+#include <stddef.h>
+
+namespace argon::core {
+
+// `HttpTransport` that never touches the network, every request is answered by the handler.
+// Used for benchmarks and for driving the core against a simulated server.
+class MemoryTransport : public HttpTransport {
+public:
+    using Handler = std::function<HttpResponse(const HttpRequest&)>;
+
+    // The handler may be called from multiple threads at once
+    explicit MemoryTransport(Handler handler);
+
+    HttpResponse send(const HttpRequest& request) override;
+
+    size_t requests() const;
+    size_t bytesSent() const;
+
+private:
+    Handler m_handler;
+    std::atomic<size_t> m_requests{0};
+    std::atomic<size_t> m_bytesSent{0};
+};
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Expected.hpp"
+#include "Transport.hpp"
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+#include <stdint.h>
+
+// Encoding of requests to and decoding of responses from the Argon server
+
+namespace argon::core {
+
+inline constexpr std::string_view CHALLENGE_START_PATH = "v1/challenge/start";
+inline constexpr std::string_view CHALLENGE_VERIFY_PATH = "v1/challenge/verify";
+inline constexpr std::string_view CHALLENGE_VERIFY_POLL_PATH = "v1/challenge/verifypoll";
+
+struct Account {
+    int accountId = 0;
+    int userId = 0;
+    std::string username;
+    std::string gjp2;
+    // Base URL of the GD server, without a trailing slash
+    std::string serverUrl;
+};
+
+struct Challenge {
+    // Either "message" or "comment"
+    std::string method;
+    // Account ID of the bot to message, or ID of the level to comment on
+    int id;
+    uint32_t challengeId;
+    int challenge;
+    std::string ident;
+};
+
+struct Verification {
+    std::string authtoken;
+    int commentId;
+    // how long the token is valid for in seconds, 0 if the server did not say
+    int64_t expiresIn = 0;
+};
+
+struct PollLater {
+    uint32_t ms;
+};
+
+using VerifyOutcome = std::variant<Verification, PollLater>;
+
+// Response of the validation endpoints, which servers use to check tokens sent to them by users
+struct ValidationVerdict {
+    bool valid = false;
+    // Strong checks only, whether the token is valid ignoring the username
+    bool validWeak = false;
+    // Reason why the token is invalid, if provided by the server
+    std::string cause;
+    // Strong checks only, the actual username of the account
+    std::string username;
+};
+
+std::string encodeChallengeStart(const Account& account, std::string_view preferredMethod, bool forceStrong, std::string_view reqMod);
+std::string encodeChallengeVerify(const Account& account, uint32_t challengeId, std::string_view solution);
+
+// Both of these also turn non-2xx responses and responses with `"success": false` into errors
+Expected<Challenge> decodeChallengeStart(const HttpResponse& response);
+Expected<VerifyOutcome> decodeChallengeVerify(const HttpResponse& response);
+
+// These take the body of a 200 response. The batch variant fails as a whole only if the response can't be read at all,
+// otherwise every verdict succeeds or fails on its own.
+Expected<ValidationVerdict> decodeValidationCheck(std::string_view body, bool strong);
+Expected<std::vector<Expected<ValidationVerdict>>> decodeValidationCheckBatch(std::string_view body, bool strong);
+
+// Human readable description of a failed request, `what` says what the request was for
+std::string describeFailure(const HttpResponse& response, std::string_view what);
+
+std::string solveChallenge(int challenge);
+// Text of the GD message or comment that delivers the solution
+std::string solutionText(std::string_view solution);
+
+}
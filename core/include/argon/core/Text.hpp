@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <stddef.h>
+
+// String helpers shared by the client and the server library
+
+namespace argon::core {
+
+// Shortens the string for use in an error message, appending "..." if anything was cut off
+std::string truncate(std::string_view s, size_t maxSize = 128);
+
+// Appends the string to `out` as a quoted JSON string
+void appendJsonString(std::string& out, std::string_view str);
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+namespace argon::core {
+
+struct StoredToken {
+    std::string url;
+    int accountId = 0;
+    int userId = 0;
+    std::string username;
+    std::string ident;
+    std::string token;
+    // Unix timestamps in seconds, 0 if unknown
+    int64_t issuedAt = 0;
+    int64_t expiresAt = 0;
+    int64_t validatedAt = 0;
+};
+
+enum class CleanupKind : uint8_t {
+    Message = 0,
+    Comment = 1,
+};
+
+// A verification message or comment that still has to be deleted
+struct PendingCleanup {
+    // URL of the GD server it was posted on
+    std::string url;
+    int accountId = 0;
+    CleanupKind kind = CleanupKind::Message;
+    int id = 0;
+    // Only used for comments
+    int levelId = 0;
+    uint32_t attempts = 0;
+    // Unix timestamp in seconds, the cleanup is not attempted before this time
+    int64_t notBefore = 0;
+
+    bool sameAs(const PendingCleanup& other) const {
+        return kind == other.kind && id == other.id && accountId == other.accountId && url == other.url;
+    }
+};
+
+// Cheap fingerprint of a file on disk, used to tell whether someone else has modified it
+struct FileStamp {
+    std::filesystem::file_time_type mtime{};
+    uintmax_t size = 0;
+    bool exists = false;
+
+    static FileStamp of(const std::filesystem::path& path);
+
+    bool operator==(const FileStamp&) const = default;
+};
+
+// In-memory copy of the tokens stored in the argon data file, indexed by (url, account ID, user ID).
+// Not thread-safe, in the mod it is only accessed with the config lock held.
+class TokenIndex {
+public:
+    const StoredToken* find(std::string_view url, int accountId, int userId) const;
+    StoredToken* find(std::string_view url, int accountId, int userId);
+
+    // Inserts the token, or replaces the existing one with the same url, account ID and user ID
+    void upsert(StoredToken token);
+
+    // Removes all tokens for this account and server, returns the amount of removed tokens
+    size_t eraseAccount(int accountId, std::string_view url);
+    // Removes all tokens for this server, returns the amount of removed tokens
+    size_t eraseServer(std::string_view url);
+
+    void assign(std::vector<StoredToken> tokens);
+    const std::vector<StoredToken>& tokens() const;
+
+private:
+    std::vector<StoredToken> m_tokens;
+    std::unordered_multimap<uint64_t, size_t> m_index;
+
+    static uint64_t makeKey(int accountId, int userId);
+    void reindex();
+};
+
+}
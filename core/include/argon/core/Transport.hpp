@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <stdint.h>
+
+namespace argon::core {
+
+enum class HttpMethod : uint8_t {
+    Get,
+    Post,
+};
+
+struct HttpRequest {
+    HttpMethod method = HttpMethod::Post;
+    std::string url;
+    // Only sent with POST requests
+    std::string body;
+    // Empty for the form encoded requests that GD servers expect
+    std::string contentType;
+    std::chrono::milliseconds timeout{10000};
+};
+
+struct HttpResponse {
+    // HTTP status code, or -1 if the request did not reach the server
+    int code = -1;
+    std::string body;
+    // Transport-level error description, if `code` is -1
+    std::string error;
+
+    bool ok() const {
+        return code >= 200 && code < 300;
+    }
+};
+
+// Blocking HTTP client, used by `AuthClient` and by the server-side validator in argon-server.
+// Every request made during authentication is a POST, token validation also uses GET.
+// Implementations must be safe to call from multiple threads at once.
+class HttpTransport {
+public:
+    virtual ~HttpTransport() = default;
+
+    virtual HttpResponse send(const HttpRequest& request) = 0;
+};
+
+}
@@ -0,0 +1,63 @@
+#include <argon/core/AuthClient.hpp>
+#include <algorithm>
+#include <thread>
+
+namespace argon::core {
+
+AuthClient::AuthClient(HttpTransport& transport, SolutionSubmitter submitter, AuthClientOptions options)
+    : m_transport(transport), m_submitter(std::move(submitter)), m_options(std::move(options))
+{
+    while (!m_options.serverUrl.empty() && m_options.serverUrl.back() == '/') {
+        m_options.serverUrl.pop_back();
+    }
+}
+
+HttpResponse AuthClient::post(std::string_view path, std::string body) {
+    return m_transport.send(HttpRequest {
+        .method = HttpMethod::Post,
+        .url = m_options.serverUrl + "/" + std::string{path},
+        .body = std::move(body),
+        .contentType = "application/json",
+        .timeout = m_options.timeout,
+    });
+}
+
+Expected<Verification> AuthClient::authenticate(const Account& account, std::string_view preferredMethod, bool forceStrong) {
+    using Clock = std::chrono::steady_clock;
+
+    auto challenge = decodeChallengeStart(this->post(CHALLENGE_START_PATH, encodeChallengeStart(account, preferredMethod, forceStrong, m_options.reqMod)));
+    if (!challenge) {
+        return Expected<Verification>::fail(std::move(challenge).error());
+    }
+
+    auto solution = solveChallenge(challenge->challenge);
+
+    if (auto err = m_submitter(account, *challenge, solutionText(solution))) {
+        return Expected<Verification>::fail(std::move(*err));
+    }
+
+    auto deadline = Clock::now() + m_options.verifyDeadline;
+    auto outcome = decodeChallengeVerify(this->post(CHALLENGE_VERIFY_PATH, encodeChallengeVerify(account, challenge->challengeId, solution)));
+
+    while (outcome && std::holds_alternative<PollLater>(*outcome)) {
+        auto& plater = std::get<PollLater>(*outcome);
+
+        // the server's delay always takes priority, but don't sleep past the deadline
+        auto wakeAt = std::min(Clock::now() + std::chrono::milliseconds(plater.ms), deadline);
+        std::this_thread::sleep_until(wakeAt);
+
+        if (Clock::now() >= deadline) {
+            return Expected<Verification>::fail("Server did not verify the solution in a reasonable amount of time");
+        }
+
+        outcome = decodeChallengeVerify(this->post(CHALLENGE_VERIFY_POLL_PATH, encodeChallengeVerify(account, challenge->challengeId, solution)));
+    }
+
+    if (!outcome) {
+        return Expected<Verification>::fail(std::move(outcome).error());
+    }
+
+    return std::get<Verification>(std::move(*outcome));
+}
+
+}
@@ -0,0 +1,267 @@
+#include <argon/core/BinaryTokenStore.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <string>
+
+static_assert(std::endian::native == std::endian::little, "Binary token store assumes a little-endian platform");
+
+namespace argon::core {
+
+static constexpr char MAGIC[4] = {'A', 'R', 'G', 'B'};
+static constexpr uint16_t VERSION = 1;
+
+template <typename T>
+static void appendRaw(std::vector<uint8_t>& out, const T& value) {
+    auto bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static T readRaw(std::span<const uint8_t> data, size_t offset) {
+    T value;
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+std::vector<uint8_t> encodeBinaryStore(uint64_t generation, const std::vector<StoredToken>& tokens, const std::vector<PendingCleanup>& cleanups) {
+    std::vector<std::string_view> urls;
+    std::vector<BinaryStoreRecord> records;
+    std::vector<BinaryStoreCleanup> cleanupRecords;
+    std::string pool;
+
+    records.reserve(tokens.size());
+    cleanupRecords.reserve(cleanups.size());
+
+    auto addString = [&](std::string_view str) {
+        BinaryStoreString out {
+            .offset = (uint32_t) pool.size(),
+            .length = (uint32_t) str.size(),
+        };
+
+        pool.append(str);
+        return out;
+    };
+
+    auto internUrl = [&](std::string_view url) {
+        // there's rarely more than a couple of distinct servers, linear search is fine
+        auto it = std::find(urls.begin(), urls.end(), url);
+        uint32_t urlIndex = it - urls.begin();
+
+        if (it == urls.end()) {
+            urls.push_back(url);
+        }
+
+        return urlIndex;
+    };
+
+    for (auto& token : tokens) {
+        records.push_back(BinaryStoreRecord {
+            .urlIndex = internUrl(token.url),
+            .accountId = token.accountId,
+            .userId = token.userId,
+            .reserved = 0,
+            .username = addString(token.username),
+            .ident = addString(token.ident),
+            .token = addString(token.token),
+            .issuedAt = token.issuedAt,
+            .expiresAt = token.expiresAt,
+            .validatedAt = token.validatedAt,
+        });
+    }
+
+    for (auto& cleanup : cleanups) {
+        cleanupRecords.push_back(BinaryStoreCleanup {
+            .urlIndex = internUrl(cleanup.url),
+            .accountId = cleanup.accountId,
+            .id = cleanup.id,
+            .levelId = cleanup.levelId,
+            .kind = (uint8_t) cleanup.kind,
+            .reserved = {},
+            .attempts = cleanup.attempts,
+            .notBefore = cleanup.notBefore,
+        });
+    }
+
+    std::vector<BinaryStoreString> urlStrings;
+    urlStrings.reserve(urls.size());
+
+    for (auto url : urls) {
+        urlStrings.push_back(addString(url));
+    }
+
+    // keep the total size aligned
+    pool.resize((pool.size() + 3) & ~size_t(3), '\0');
+
+    BinaryStoreHeader header {
+        .magic = {MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3]},
+        .version = VERSION,
+        .headerSize = sizeof(BinaryStoreHeader),
+        .generation = generation,
+        .jsonSize = 0,
+        .jsonMtime = 0,
+        .urlCount = (uint32_t) urlStrings.size(),
+        .recordCount = (uint32_t) records.size(),
+        .recordSize = sizeof(BinaryStoreRecord),
+        .stringsSize = (uint32_t) pool.size(),
+        .cleanupCount = (uint32_t) cleanupRecords.size(),
+        .cleanupSize = sizeof(BinaryStoreCleanup),
+    };
+
+    std::vector<uint8_t> out;
+    out.reserve(
+        sizeof(header)
+        + urlStrings.size() * sizeof(BinaryStoreString)
+        + records.size() * sizeof(BinaryStoreRecord)
+        + cleanupRecords.size() * sizeof(BinaryStoreCleanup)
+        + pool.size()
+    );
+
+    appendRaw(out, header);
+
+    for (auto& url : urlStrings) {
+        appendRaw(out, url);
+    }
+
+    for (auto& record : records) {
+        appendRaw(out, record);
+    }
+
+    for (auto& cleanup : cleanupRecords) {
+        appendRaw(out, cleanup);
+    }
+
+    out.insert(out.end(), pool.begin(), pool.end());
+
+    return out;
+}
+
+Expected<BinaryStoreContents> decodeBinaryStore(std::span<const uint8_t> data) {
+    if (data.size() < sizeof(BinaryStoreHeader)) {
+        return Expected<BinaryStoreContents>::fail("file too small");
+    }
+
+    auto header = readRaw<BinaryStoreHeader>(data, 0);
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        return Expected<BinaryStoreContents>::fail("invalid magic");
+    }
+
+    if (header.version != VERSION) {
+        return Expected<BinaryStoreContents>::fail("unsupported version " + std::to_string(header.version));
+    }
+
+    // newer writers may append fields to the header and records, they must never change existing ones
+    if (
+        header.headerSize < sizeof(BinaryStoreHeader)
+        || header.recordSize < sizeof(BinaryStoreRecord)
+        || (header.cleanupCount != 0 && header.cleanupSize < sizeof(BinaryStoreCleanup))
+    ) {
+        return Expected<BinaryStoreContents>::fail("invalid header");
+    }
+
+    uint64_t urlsOffset = header.headerSize;
+    uint64_t recordsOffset = urlsOffset + (uint64_t) header.urlCount * sizeof(BinaryStoreString);
+    uint64_t cleanupsOffset = recordsOffset + (uint64_t) header.recordCount * header.recordSize;
+    uint64_t stringsOffset = cleanupsOffset + (uint64_t) header.cleanupCount * header.cleanupSize;
+
+    if (stringsOffset + header.stringsSize > data.size()) {
+        return Expected<BinaryStoreContents>::fail("file truncated");
+    }
+
+    auto strings = data.subspan(stringsOffset, header.stringsSize);
+
+    auto inBounds = [&](BinaryStoreString str) {
+        return (uint64_t) str.offset + str.length <= strings.size();
+    };
+
+    auto readString = [&](BinaryStoreString str) {
+        return std::string{reinterpret_cast<const char*>(strings.data()) + str.offset, str.length};
+    };
+
+    std::vector<std::string> urls;
+    urls.reserve(header.urlCount);
+
+    for (uint32_t i = 0; i < header.urlCount; i++) {
+        auto str = readRaw<BinaryStoreString>(data, urlsOffset + i * sizeof(BinaryStoreString));
+        if (!inBounds(str)) {
+            return Expected<BinaryStoreContents>::fail("string out of bounds");
+        }
+
+        urls.push_back(readString(str));
+    }
+
+    BinaryStoreContents out {
+        .generation = header.generation,
+        .jsonSize = header.jsonSize,
+        .jsonMtime = header.jsonMtime,
+        .tokens = {},
+        .cleanups = {},
+    };
+    out.tokens.reserve(header.recordCount);
+    out.cleanups.reserve(header.cleanupCount);
+
+    for (uint32_t i = 0; i < header.recordCount; i++) {
+        auto record = readRaw<BinaryStoreRecord>(data, recordsOffset + (uint64_t) i * header.recordSize);
+
+        if (record.urlIndex >= urls.size()) {
+            return Expected<BinaryStoreContents>::fail("url index out of bounds");
+        }
+
+        if (!inBounds(record.username) || !inBounds(record.ident) || !inBounds(record.token)) {
+            return Expected<BinaryStoreContents>::fail("string out of bounds");
+        }
+
+        out.tokens.push_back(StoredToken {
+            .url = urls[record.urlIndex],
+            .accountId = record.accountId,
+            .userId = record.userId,
+            .username = readString(record.username),
+            .ident = readString(record.ident),
+            .token = readString(record.token),
+            .issuedAt = record.issuedAt,
+            .expiresAt = record.expiresAt,
+            .validatedAt = record.validatedAt,
+        });
+    }
+
+    for (uint32_t i = 0; i < header.cleanupCount; i++) {
+        auto cleanup = readRaw<BinaryStoreCleanup>(data, cleanupsOffset + (uint64_t) i * header.cleanupSize);
+
+        if (cleanup.urlIndex >= urls.size()) {
+            return Expected<BinaryStoreContents>::fail("url index out of bounds");
+        }
+
+        out.cleanups.push_back(PendingCleanup {
+            .url = urls[cleanup.urlIndex],
+            .accountId = cleanup.accountId,
+            .kind = cleanup.kind == (uint8_t) CleanupKind::Comment ? CleanupKind::Comment : CleanupKind::Message,
+            .id = cleanup.id,
+            .levelId = cleanup.levelId,
+            .attempts = cleanup.attempts,
+            .notBefore = cleanup.notBefore,
+        });
+    }
+
+    return out;
+}
+
+std::array<uint8_t, BINARY_STORE_STAMP_SIZE> encodeBinaryStoreStamp(const FileStamp& stamp) {
+    uint64_t size = stamp.size;
+    int64_t mtime = stamp.mtime.time_since_epoch().count();
+
+    std::array<uint8_t, BINARY_STORE_STAMP_SIZE> out;
+    std::memcpy(out.data(), &size, sizeof(size));
+    std::memcpy(out.data() + sizeof(size), &mtime, sizeof(mtime));
+
+    return out;
+}
+
+bool binaryStoreMatches(const BinaryStoreContents& contents, const FileStamp& jsonStamp) {
+    return jsonStamp.exists
+        && contents.jsonSize == jsonStamp.size
+        && contents.jsonMtime == (int64_t) jsonStamp.mtime.time_since_epoch().count();
+}
+
+}
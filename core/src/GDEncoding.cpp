@@ -0,0 +1,12 @@
+#include <argon/core/GDEncoding.hpp>
+
+namespace argon::core {
+
+void appendGDBase64(std::string& out, std::string_view data, std::string_view key) {
+    size_t offset = out.size();
+    out.resize(offset + gdBase64Size(data.size()));
+
+    encodeGDBase64(out.data() + offset, data, key);
+}
+
+}
@@ -0,0 +1,269 @@
+#include "Json.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+
+namespace argon::core {
+
+// Deeper documents are rejected instead of risking a stack overflow, Argon responses are at most a few levels deep
+static constexpr size_t MAX_DEPTH = 64;
+
+JsonType JsonReader::peek() {
+    this->skipWs();
+    if (m_pos >= m_data.size()) return JsonType::Invalid;
+
+    switch (m_data[m_pos]) {
+        case '"': return JsonType::String;
+        case '[': return JsonType::Array;
+        case '{': return JsonType::Object;
+        case 't': case 'f': return JsonType::Bool;
+        case 'n': return JsonType::Null;
+        case '-': case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            return JsonType::Number;
+        default: return JsonType::Invalid;
+    }
+}
+
+bool JsonReader::read(std::optional<bool>& out) {
+    if (this->peek() != JsonType::Bool) {
+        out.reset();
+        return this->skip();
+    }
+
+    if (this->consumeWord("true")) {
+        out = true;
+        return true;
+    }
+
+    if (this->consumeWord("false")) {
+        out = false;
+        return true;
+    }
+
+    return false;
+}
+
+bool JsonReader::read(std::optional<int64_t>& out) {
+    out.reset();
+
+    if (this->peek() != JsonType::Number) {
+        return this->skip();
+    }
+
+    auto str = this->parseNumber();
+    if (!str) return false;
+
+    // integers are read separately so that large IDs don't lose precision
+    int64_t value = 0;
+    auto res = std::from_chars(str->data(), str->data() + str->size(), value);
+    if (res.ec == std::errc{} && res.ptr == str->data() + str->size()) {
+        out = value;
+        return true;
+    }
+
+    // from_chars for doubles is not available everywhere yet
+    std::string owned{*str};
+    char* end = nullptr;
+    double number = std::strtod(owned.c_str(), &end);
+    if (end != owned.c_str() + owned.size()) return false;
+
+    // e.g. 1e3 or 5.0, anything else is valid JSON but not an integer
+    if (std::trunc(number) == number && std::abs(number) < 9.2e18) {
+        out = (int64_t) number;
+    }
+
+    return true;
+}
+
+bool JsonReader::read(std::optional<std::string>& out) {
+    if (this->peek() != JsonType::String) {
+        out.reset();
+        return this->skip();
+    }
+
+    if (out) {
+        out->clear();
+    } else {
+        out.emplace();
+    }
+
+    return this->parseString(&*out);
+}
+
+bool JsonReader::skip() {
+    switch (this->peek()) {
+        case JsonType::String:
+            return this->parseString(nullptr);
+        case JsonType::Number:
+            return this->parseNumber().has_value();
+        case JsonType::Array:
+            return this->readArray([&] { return this->skip(); });
+        case JsonType::Object:
+            return this->readObject([&](std::string_view) { return this->skip(); });
+        case JsonType::Bool:
+            return this->consumeWord("true") || this->consumeWord("false");
+        case JsonType::Null:
+            return this->consumeWord("null");
+        case JsonType::Invalid:
+            return false;
+    }
+
+    return false;
+}
+
+bool JsonReader::atEnd() {
+    this->skipWs();
+    return m_pos == m_data.size();
+}
+
+bool JsonReader::enter(char open) {
+    this->skipWs();
+
+    if (m_depth >= MAX_DEPTH || !this->consume(open)) return false;
+
+    m_depth++;
+    return true;
+}
+
+bool JsonReader::leave() {
+    m_depth--;
+    return true;
+}
+
+bool JsonReader::consume(char c) {
+    if (m_pos < m_data.size() && m_data[m_pos] == c) {
+        m_pos++;
+        return true;
+    }
+
+    return false;
+}
+
+bool JsonReader::consumeWord(std::string_view word) {
+    if (m_data.substr(m_pos).starts_with(word)) {
+        m_pos += word.size();
+        return true;
+    }
+
+    return false;
+}
+
+void JsonReader::skipWs() {
+    while (m_pos < m_data.size()) {
+        char c = m_data[m_pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+        m_pos++;
+    }
+}
+
+static void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back((char) cp);
+    } else if (cp < 0x800) {
+        out.push_back((char) (0xc0 | (cp >> 6)));
+        out.push_back((char) (0x80 | (cp & 0x3f)));
+    } else if (cp < 0x10000) {
+        out.push_back((char) (0xe0 | (cp >> 12)));
+        out.push_back((char) (0x80 | ((cp >> 6) & 0x3f)));
+        out.push_back((char) (0x80 | (cp & 0x3f)));
+    } else {
+        out.push_back((char) (0xf0 | (cp >> 18)));
+        out.push_back((char) (0x80 | ((cp >> 12) & 0x3f)));
+        out.push_back((char) (0x80 | ((cp >> 6) & 0x3f)));
+        out.push_back((char) (0x80 | (cp & 0x3f)));
+    }
+}
+
+std::optional<uint32_t> JsonReader::parseHex4() {
+    if (m_pos + 4 > m_data.size()) return std::nullopt;
+
+    uint32_t value = 0;
+    auto res = std::from_chars(m_data.data() + m_pos, m_data.data() + m_pos + 4, value, 16);
+    if (res.ec != std::errc{} || res.ptr != m_data.data() + m_pos + 4) return std::nullopt;
+
+    m_pos += 4;
+    return value;
+}
+
+bool JsonReader::parseString(std::string* out) {
+    if (!this->consume('"')) return false;
+
+    while (m_pos < m_data.size()) {
+        // copy everything up to the next quote or escape at once, control characters are only allowed escaped
+        size_t end = m_pos;
+        while (end < m_data.size() && m_data[end] != '"' && m_data[end] != '\\') {
+            if ((unsigned char) m_data[end] < 0x20) return false;
+            end++;
+        }
+
+        if (end == m_data.size()) return false;
+
+        if (out) out->append(m_data.substr(m_pos, end - m_pos));
+        m_pos = end + 1;
+
+        if (m_data[end] == '"') return true;
+
+        if (m_pos >= m_data.size()) return false;
+
+        char escaped;
+
+        switch (m_data[m_pos++]) {
+            case '"': escaped = '"'; break;
+            case '\\': escaped = '\\'; break;
+            case '/': escaped = '/'; break;
+            case 'b': escaped = '\b'; break;
+            case 'f': escaped = '\f'; break;
+            case 'n': escaped = '\n'; break;
+            case 'r': escaped = '\r'; break;
+            case 't': escaped = '\t'; break;
+            case 'u': {
+                auto cp = this->parseHex4();
+                if (!cp) return false;
+
+                // surrogate pair
+                if (*cp >= 0xd800 && *cp < 0xdc00 && this->consumeWord("\\u")) {
+                    auto low = this->parseHex4();
+                    if (!low || *low < 0xdc00 || *low >= 0xe000) return false;
+
+                    *cp = 0x10000 + ((*cp - 0xd800) << 10) + (*low - 0xdc00);
+                }
+
+                if (out) appendUtf8(*out, *cp);
+                continue;
+            }
+            default: return false;
+        }
+
+        if (out) out->push_back(escaped);
+    }
+
+    return false;
+}
+
+std::optional<std::string_view> JsonReader::parseNumber() {
+    size_t start = m_pos;
+
+    auto digits = [&] {
+        size_t from = m_pos;
+        while (m_pos < m_data.size() && m_data[m_pos] >= '0' && m_data[m_pos] <= '9') m_pos++;
+        return m_pos != from;
+    };
+
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    // a leading zero ends the integer part, so "01" leaves "1" behind and fails wherever the number was used
+    this->consume('-');
+
+    if (!this->consume('0') && !digits()) return std::nullopt;
+
+    if (this->consume('.') && !digits()) return std::nullopt;
+
+    if (this->consume('e') || this->consume('E')) {
+        if (!this->consume('+')) this->consume('-');
+        if (!digits()) return std::nullopt;
+    }
+
+    return m_data.substr(start, m_pos - start);
+}
+
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <argon/core/Text.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace argon::core {
+
+enum class JsonType : uint8_t {
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object,
+    // Anything that can't start a valid value, including the end of the input
+    Invalid,
+};
+
+// Reads a JSON document front to back in a single pass, without building a tree of it. Values are read straight
+// into the variables they end up in, everything else is skipped over (but still validated).
+class JsonReader {
+public:
+    JsonReader(std::string_view data) : m_data(data) {}
+
+    // Type of the next value, without consuming it
+    JsonType peek();
+
+    // Reads an object, calling `onKey(std::string_view key)` for every key. The key is only valid until the value is read.
+    // The callback must consume the value, and return false if that failed.
+    template <typename F>
+    bool readObject(F&& onKey) {
+        if (!this->enter('{')) return false;
+
+        this->skipWs();
+        if (this->consume('}')) return this->leave();
+
+        while (true) {
+            this->skipWs();
+
+            m_key.clear();
+            if (!this->parseString(&m_key)) return false;
+
+            this->skipWs();
+            if (!this->consume(':')) return false;
+            this->skipWs();
+
+            if (!onKey(std::string_view{m_key})) return false;
+
+            this->skipWs();
+            if (this->consume(',')) continue;
+            if (this->consume('}')) return this->leave();
+
+            return false;
+        }
+    }
+
+    // Reads an array, calling `onItem()` for every element, which must consume it
+    template <typename F>
+    bool readArray(F&& onItem) {
+        if (!this->enter('[')) return false;
+
+        this->skipWs();
+        if (this->consume(']')) return this->leave();
+
+        while (true) {
+            this->skipWs();
+            if (!onItem()) return false;
+
+            this->skipWs();
+            if (this->consume(',')) continue;
+            if (this->consume(']')) return this->leave();
+
+            return false;
+        }
+    }
+
+    // These accept a value of any type, and return false only if it's malformed.
+    // A value of another type is skipped and resets `out`, so it's treated the same as a missing one.
+    bool read(std::optional<bool>& out);
+    // Only integers that fit into 64 bits count, 1e3 or 5.0 are fine too
+    bool read(std::optional<int64_t>& out);
+    bool read(std::optional<std::string>& out);
+
+    bool skip();
+
+    // Whether only whitespace is left
+    bool atEnd();
+
+private:
+    std::string_view m_data;
+    size_t m_pos = 0;
+    size_t m_depth = 0;
+    // reused for every key, so that reading keys does not allocate
+    std::string m_key;
+
+    bool enter(char open);
+    bool leave();
+
+    bool consume(char c);
+    bool consumeWord(std::string_view word);
+    void skipWs();
+
+    std::optional<uint32_t> parseHex4();
+    // Unescapes the string into `out`, or only validates it if `out` is null
+    bool parseString(std::string* out);
+    // The raw number, e.g. "-12.5e3", following the JSON number grammar
+    std::optional<std::string_view> parseNumber();
+};
+
+// One known key of an object and how to read its value into `T`
+template <typename T>
+struct JsonField {
+    std::string_view key;
+    bool (*read)(JsonReader& reader, T& out);
+};
+
+template <typename M>
+struct JsonMemberOf;
+
+template <typename C, typename V>
+struct JsonMemberOf<V C::*> {
+    using type = C;
+};
+
+// Field that is read straight into a data member, e.g. `jsonField<&Foo::name>("name")`
+template <auto Member>
+constexpr JsonField<typename JsonMemberOf<decltype(Member)>::type> jsonField(std::string_view key) {
+    using T = typename JsonMemberOf<decltype(Member)>::type;
+
+    return { key, [](JsonReader& reader, T& out) { return reader.read(out.*Member); } };
+}
+
+// Reads an object according to the schema, keys not in it are skipped. If the value isn't an object at all, it is skipped
+// and `out` is left untouched. If a key appears twice, the last value wins.
+template <typename T, size_t N>
+bool readJsonFields(JsonReader& reader, T& out, const JsonField<T> (&schema)[N]) {
+    if (reader.peek() != JsonType::Object) {
+        return reader.skip();
+    }
+
+    return reader.readObject([&](std::string_view key) {
+        // every schema has a handful of keys, a linear scan is faster than any map
+        for (auto& field : schema) {
+            if (field.key == key) {
+                return field.read(reader, out);
+            }
+        }
+
+        return reader.skip();
+    });
+}
+
+}
@@ -0,0 +1,23 @@
+#include <argon/core/MemoryTransport.hpp>
+#include <utility>
+
+namespace argon::core {
+
+MemoryTransport::MemoryTransport(Handler handler) : m_handler(std::move(handler)) {}
+
+HttpResponse MemoryTransport::send(const HttpRequest& request) {
+    m_requests.fetch_add(1, std::memory_order::relaxed);
+    m_bytesSent.fetch_add(request.body.size(), std::memory_order::relaxed);
+
+    return m_handler(request);
+}
+
+size_t MemoryTransport::requests() const {
+    return m_requests.load(std::memory_order::relaxed);
+}
+
+size_t MemoryTransport::bytesSent() const {
+    return m_bytesSent.load(std::memory_order::relaxed);
+}
+
+}
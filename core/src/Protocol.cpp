@@ -0,0 +1,286 @@
+#include <argon/core/Protocol.hpp>
+#include "Json.hpp"
+#include <limits>
+
+namespace argon::core {
+
+std::string describeFailure(const HttpResponse& response, std::string_view what) {
+    if (response.code == -1) {
+        // transport error, request did not even reach the server
+        std::string fullmsg = response.body;
+        if (!response.error.empty()) {
+            if (fullmsg.empty()) {
+                fullmsg = response.error;
+            } else {
+                fullmsg += " (" + response.error + ")";
+            }
+        }
+
+        if (fullmsg.empty()) {
+            fullmsg = "(unknown error, response and error buffer are empty)";
+        }
+
+        return "Request error (" + std::string{what} + "): " + truncate(fullmsg);
+    }
+
+    // server error
+    std::string_view resp = response.body;
+    if (resp.empty()) {
+        resp = "(no response body)";
+    }
+
+    return "Server error (" + std::string{what} + ", code " + std::to_string(response.code) + "): " + truncate(resp);
+}
+
+// Checks the status code and the `success` field, and reads `data` according to the schema, all in one pass
+template <typename Data, size_t N>
+static Expected<Data> decodeEnvelope(const HttpResponse& response, std::string_view what, const JsonField<Data> (&schema)[N]) {
+    if (!response.ok()) {
+        return Expected<Data>::fail(describeFailure(response, what));
+    }
+
+    JsonReader reader{response.body};
+
+    std::optional<bool> success;
+    std::optional<std::string> error;
+    Data data{};
+
+    bool valid;
+    if (reader.peek() == JsonType::Object) {
+        valid = reader.readObject([&](std::string_view key) {
+            if (key == "success") return reader.read(success);
+            if (key == "error") return reader.read(error);
+
+            if (key == "data") {
+                data = Data{};
+                return readJsonFields(reader, data, schema);
+            }
+
+            return reader.skip();
+        });
+    } else {
+        // valid JSON, but not what we expected, reported as a missing error message below
+        valid = reader.skip();
+    }
+
+    if (!valid || !reader.atEnd()) {
+        return Expected<Data>::fail("Malformed server response (invalid JSON)");
+    }
+
+    if (!success.value_or(false)) {
+        return Expected<Data>::fail(describeFailure(response, error ? std::string_view{*error} : "Malformed server response (no error message)"));
+    }
+
+    return data;
+}
+
+template <typename T>
+static std::optional<T> narrow(std::optional<int64_t> num) {
+    if (!num || *num < std::numeric_limits<T>::min() || *num > std::numeric_limits<T>::max()) {
+        return std::nullopt;
+    }
+
+    return (T) *num;
+}
+
+// Raw contents of `data` in responses, converted to the public types once the whole response is read
+
+struct ChallengeFields {
+    std::optional<std::string> method;
+    std::optional<int64_t> id;
+    std::optional<int64_t> challengeId;
+    std::optional<int64_t> challenge;
+    std::optional<std::string> ident;
+};
+
+static constexpr JsonField<ChallengeFields> CHALLENGE_SCHEMA[] = {
+    jsonField<&ChallengeFields::method>("method"),
+    jsonField<&ChallengeFields::id>("id"),
+    jsonField<&ChallengeFields::challengeId>("challengeId"),
+    jsonField<&ChallengeFields::challenge>("challenge"),
+    jsonField<&ChallengeFields::ident>("ident"),
+};
+
+struct VerifyFields {
+    std::optional<bool> verified;
+    std::optional<std::string> authtoken;
+    std::optional<int64_t> commentId;
+    std::optional<int64_t> expiresIn;
+    std::optional<int64_t> pollAfter;
+};
+
+static constexpr JsonField<VerifyFields> VERIFY_SCHEMA[] = {
+    jsonField<&VerifyFields::verified>("verified"),
+    jsonField<&VerifyFields::authtoken>("authtoken"),
+    jsonField<&VerifyFields::commentId>("commentId"),
+    jsonField<&VerifyFields::expiresIn>("expiresIn"),
+    jsonField<&VerifyFields::pollAfter>("pollAfter"),
+};
+
+struct VerdictFields {
+    std::optional<bool> valid;
+    std::optional<bool> validWeak;
+    std::optional<std::string> cause;
+    std::optional<std::string> username;
+};
+
+static constexpr JsonField<VerdictFields> VERDICT_SCHEMA[] = {
+    jsonField<&VerdictFields::valid>("valid"),
+    jsonField<&VerdictFields::validWeak>("valid_weak"),
+    jsonField<&VerdictFields::cause>("cause"),
+    jsonField<&VerdictFields::username>("username"),
+};
+
+std::string encodeChallengeStart(const Account& account, std::string_view preferredMethod, bool forceStrong, std::string_view reqMod) {
+    std::string out;
+    out.reserve(128 + account.username.size() + reqMod.size());
+
+    out += "{\"accountId\":";
+    out += std::to_string(account.accountId);
+    out += ",\"userId\":";
+    out += std::to_string(account.userId);
+    out += ",\"username\":";
+    appendJsonString(out, account.username);
+    out += ",\"forceStrong\":";
+    out += forceStrong ? "true" : "false";
+    out += ",\"reqMod\":";
+    appendJsonString(out, reqMod);
+    out += ",\"preferred\":";
+    appendJsonString(out, preferredMethod);
+    out += '}';
+
+    return out;
+}
+
+std::string encodeChallengeVerify(const Account& account, uint32_t challengeId, std::string_view solution) {
+    std::string out;
+    out.reserve(96 + solution.size());
+
+    out += "{\"challengeId\":";
+    out += std::to_string(challengeId);
+    out += ",\"accountId\":";
+    out += std::to_string(account.accountId);
+    out += ",\"solution\":";
+    appendJsonString(out, solution);
+    out += '}';
+
+    return out;
+}
+
+Expected<Challenge> decodeChallengeStart(const HttpResponse& response) {
+    auto data = decodeEnvelope(response, "challenge start", CHALLENGE_SCHEMA);
+    if (!data) {
+        return Expected<Challenge>::fail(std::move(data).error());
+    }
+
+    auto id = narrow<int>(data->id);
+    auto challengeId = narrow<uint32_t>(data->challengeId);
+    auto challenge = narrow<int>(data->challenge);
+
+    if (!data->method || !id || !challengeId || !challenge || !data->ident) {
+        return Expected<Challenge>::fail("Malformed Stage1ResponseData: missing required fields");
+    }
+
+    return Challenge {
+        .method = std::move(*data->method),
+        .id = *id,
+        .challengeId = *challengeId,
+        .challenge = *challenge,
+        .ident = std::move(*data->ident),
+    };
+}
+
+Expected<VerifyOutcome> decodeChallengeVerify(const HttpResponse& response) {
+    auto data = decodeEnvelope(response, "challenge verify", VERIFY_SCHEMA);
+    if (!data) {
+        return Expected<VerifyOutcome>::fail(std::move(data).error());
+    }
+
+    if (data->verified.value_or(false)) {
+        if (!data->authtoken || data->authtoken->empty()) {
+            return Expected<VerifyOutcome>::fail("Malformed server response (missing auth token)");
+        }
+
+        return VerifyOutcome{Verification {
+            .authtoken = std::move(*data->authtoken),
+            .commentId = narrow<int>(data->commentId).value_or(0),
+            .expiresIn = data->expiresIn.value_or(0),
+        }};
+    }
+
+    return VerifyOutcome{PollLater {
+        .ms = narrow<uint32_t>(data->pollAfter).value_or(1000),
+    }};
+}
+
+static Expected<ValidationVerdict> toVerdict(VerdictFields&& fields, bool strong) {
+    if (!fields.valid) {
+        return Expected<ValidationVerdict>::fail("Malformed server response (missing 'valid')");
+    }
+
+    ValidationVerdict verdict;
+    verdict.valid = *fields.valid;
+    verdict.cause = std::move(fields.cause).value_or("");
+
+    if (strong) {
+        if (!fields.validWeak) {
+            return Expected<ValidationVerdict>::fail("Malformed server response (missing 'valid_weak')");
+        }
+
+        verdict.validWeak = *fields.validWeak;
+        verdict.username = std::move(fields.username).value_or("");
+    }
+
+    return verdict;
+}
+
+// Unlike `data` in the other responses, a verdict that isn't an object makes the whole response malformed
+static bool readVerdict(JsonReader& reader, VerdictFields& out) {
+    return reader.peek() == JsonType::Object && readJsonFields(reader, out, VERDICT_SCHEMA);
+}
+
+static std::string malformedBody(std::string_view body) {
+    return "Malformed server response: " + truncate(body);
+}
+
+Expected<ValidationVerdict> decodeValidationCheck(std::string_view body, bool strong) {
+    JsonReader reader{body};
+    VerdictFields fields;
+
+    if (!readVerdict(reader, fields) || !reader.atEnd()) {
+        return Expected<ValidationVerdict>::fail(malformedBody(body));
+    }
+
+    return toVerdict(std::move(fields), strong);
+}
+
+Expected<std::vector<Expected<ValidationVerdict>>> decodeValidationCheckBatch(std::string_view body, bool strong) {
+    using Verdicts = std::vector<Expected<ValidationVerdict>>;
+
+    JsonReader reader{body};
+    Verdicts verdicts;
+
+    bool valid = reader.peek() == JsonType::Array && reader.readArray([&] {
+        VerdictFields fields;
+        if (!readVerdict(reader, fields)) return false;
+
+        verdicts.push_back(toVerdict(std::move(fields), strong));
+        return true;
+    });
+
+    if (!valid || !reader.atEnd()) {
+        return Expected<Verdicts>::fail(malformedBody(body));
+    }
+
+    return verdicts;
+}
+
+std::string solveChallenge(int challenge) {
+    return std::to_string(challenge ^ 0x5F3759DF);
+}
+
+std::string solutionText(std::string_view solution) {
+    return "#ARGON# " + std::string{solution};
+}
+
+}
@@ -0,0 +1,41 @@
+#include <argon/core/Text.hpp>
+
+namespace argon::core {
+
+std::string truncate(std::string_view s, size_t maxSize) {
+    if (s.size() < maxSize) {
+        return std::string{s};
+    }
+
+    std::string out{s.substr(0, maxSize)};
+    out += "...";
+    return out;
+}
+
+void appendJsonString(std::string& out, std::string_view str) {
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    out.push_back('"');
+
+    for (char c : str) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ((unsigned char) c < 0x20) {
+                    out += "\\u00";
+                    out.push_back(HEX[(c >> 4) & 0xf]);
+                    out.push_back(HEX[c & 0xf]);
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+
+    out.push_back('"');
+}
+
+}
@@ -0,0 +1,98 @@
+#include <argon/core/TokenIndex.hpp>
+#include <utility>
+
+namespace argon::core {
+
+FileStamp FileStamp::of(const std::filesystem::path& path) {
+    std::error_code ec;
+
+    FileStamp stamp;
+    stamp.size = std::filesystem::file_size(path, ec);
+    if (ec) return {};
+
+    stamp.mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return {};
+
+    stamp.exists = true;
+    return stamp;
+}
+
+uint64_t TokenIndex::makeKey(int accountId, int userId) {
+    return ((uint64_t)(uint32_t)accountId << 32) | (uint32_t)userId;
+}
+
+const StoredToken* TokenIndex::find(std::string_view url, int accountId, int userId) const {
+    auto [begin, end] = m_index.equal_range(makeKey(accountId, userId));
+
+    for (auto it = begin; it != end; it++) {
+        auto& token = m_tokens[it->second];
+        if (token.url == url) {
+            return &token;
+        }
+    }
+
+    return nullptr;
+}
+
+StoredToken* TokenIndex::find(std::string_view url, int accountId, int userId) {
+    return const_cast<StoredToken*>(std::as_const(*this).find(url, accountId, userId));
+}
+
+void TokenIndex::upsert(StoredToken token) {
+    auto [begin, end] = m_index.equal_range(makeKey(token.accountId, token.userId));
+
+    for (auto it = begin; it != end; it++) {
+        auto& existing = m_tokens[it->second];
+        if (existing.url == token.url) {
+            existing = std::move(token);
+            return;
+        }
+    }
+
+    m_index.emplace(makeKey(token.accountId, token.userId), m_tokens.size());
+    m_tokens.push_back(std::move(token));
+}
+
+size_t TokenIndex::eraseAccount(int accountId, std::string_view url) {
+    size_t removed = std::erase_if(m_tokens, [&](const StoredToken& token) {
+        return token.accountId == accountId && token.url == url;
+    });
+
+    if (removed != 0) {
+        this->reindex();
+    }
+
+    return removed;
+}
+
+size_t TokenIndex::eraseServer(std::string_view url) {
+    size_t removed = std::erase_if(m_tokens, [&](const StoredToken& token) {
+        return token.url == url;
+    });
+
+    if (removed != 0) {
+        this->reindex();
+    }
+
+    return removed;
+}
+
+void TokenIndex::assign(std::vector<StoredToken> tokens) {
+    m_tokens = std::move(tokens);
+    this->reindex();
+}
+
+const std::vector<StoredToken>& TokenIndex::tokens() const {
+    return m_tokens;
+}
+
+void TokenIndex::reindex() {
+    m_index.clear();
+    m_index.reserve(m_tokens.size());
+
+    for (size_t i = 0; i < m_tokens.size(); i++) {
+        m_index.emplace(makeKey(m_tokens[i].accountId, m_tokens[i].userId), i);
+    }
+}
+
+}
@@ -0,0 +1,143 @@
+// Malformed and edge case inputs for the JSON reader that decodes every Argon server response
+
+#include "Json.hpp"
+#include <argon/core/Protocol.hpp>
+
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+
+using namespace argon::core;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+// Whether the input is a complete, valid JSON document
+static bool isValid(std::string_view json) {
+    JsonReader reader{json};
+    return reader.skip() && reader.atEnd();
+}
+
+static std::optional<int64_t> readInt(std::string_view json) {
+    JsonReader reader{json};
+    std::optional<int64_t> out;
+
+    if (!reader.read(out) || !reader.atEnd()) return std::nullopt;
+    return out;
+}
+
+static std::optional<std::string> readString(std::string_view json) {
+    JsonReader reader{json};
+    std::optional<std::string> out;
+
+    if (!reader.read(out) || !reader.atEnd()) return std::nullopt;
+    return out;
+}
+
+static void testNumbers() {
+    for (auto json : {"0", "-0", "7", "-12", "1.5", "-0.25", "1e3", "1E+3", "2.5e-3", "123456789012345678", "[1, -2, 3.0]"}) {
+        CHECK(isValid(json));
+    }
+
+    // none of these match -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    for (auto json : {"-", "+1", "01", "-01", "00", "1.", ".5", "-.5", "1.e3", "1e", "1e+", "1E-", "1-2", "1+2", "1..2", "1e3e4", "1.2.3", "--1", "0x10", "[1-]", "{\"a\": 1e}"}) {
+        CHECK(!isValid(json));
+    }
+
+    CHECK(readInt("42") == 42);
+    CHECK(readInt("-42") == -42);
+    CHECK(readInt("1e3") == 1000);
+    CHECK(readInt("5.0") == 5);
+    CHECK(readInt("9007199254740993") == 9007199254740993);
+
+    // valid numbers that aren't integers read as missing, invalid ones fail the whole read
+    {
+        JsonReader reader{"1.5"};
+        std::optional<int64_t> out = 1;
+        CHECK(reader.read(out) && !out);
+    }
+
+    CHECK(!readInt("1.2.3"));
+    CHECK(!readInt("1e"));
+    CHECK(!readInt("-"));
+}
+
+static void testStrings() {
+    CHECK(readString(R"("plain")") == "plain");
+    CHECK(readString(R"("a\"b\\c\/d")") == "a\"b\\c/d");
+    CHECK(readString(R"("\b\f\n\r\t")") == "\b\f\n\r\t");
+    CHECK(readString(R"("\u0041\u00e9")") == "A\xc3\xa9");
+    CHECK(readString(R"("\ud83d\ude00")") == "\xf0\x9f\x98\x80");
+    CHECK(readString("\"\x7f\"") == "\x7f");
+
+    // raw control characters must be escaped
+    for (char c = 0; c < 0x20; c++) {
+        std::string json = "\"a";
+        json.push_back(c);
+        json += "b\"";
+
+        CHECK(!isValid(json));
+    }
+
+    CHECK(!isValid("{\"ke\ny\": 1}"));
+    CHECK(!isValid("[\"\t\"]"));
+
+    for (auto json : {"\"", "\"abc", "\"\\\"", "\"\\x\"", "\"\\u12\"", "\"\\u12g4\"", "\"\\ud83d\\u0041\"", "'single'"}) {
+        CHECK(!isValid(json));
+    }
+}
+
+static void testStructure() {
+    for (auto json : {"{}", "[]", " { \"a\" : [ true , false , null ] } ", "{\"a\": {\"b\": [{}]}}"}) {
+        CHECK(isValid(json));
+    }
+
+    for (auto json : {"", " ", "{", "}", "[", "[1,]", "[,1]", "{\"a\"}", "{\"a\":}", "{\"a\":1,}", "{a:1}", "[1 2]", "tru", "nul", "[true false]", "{} {}", "[]]"}) {
+        CHECK(!isValid(json));
+    }
+
+    std::string deep(100, '[');
+    deep += std::string(100, ']');
+    CHECK(!isValid(deep));
+}
+
+static void testResponses() {
+    auto verdict = decodeValidationCheck(R"({"valid": true, "valid_weak": true, "username": "RobTop"})", true);
+    CHECK(verdict && verdict->valid && verdict->username == "RobTop");
+
+    CHECK(!decodeValidationCheck(R"({"valid": true, "valid_weak": 01})", true));
+    CHECK(!decodeValidationCheck("{\"valid\": true, \"cause\": \"bad\ttab\"}", false));
+    CHECK(!decodeValidationCheck(R"({"valid": true} trailing)", false));
+    CHECK(!decodeValidationCheck(R"({"valid": 1})", false));
+
+    HttpResponse response;
+    response.code = 200;
+    response.body = R"({"success": true, "data": {"method": "message", "id": 1e, "challengeId": 2, "challenge": 3, "ident": "x"}})";
+    CHECK(!decodeChallengeStart(response));
+
+    response.body = R"({"success": true, "data": {"method": "message", "id": 1, "challengeId": 2, "challenge": 3, "ident": "x"}})";
+    auto challenge = decodeChallengeStart(response);
+    CHECK(challenge && challenge->id == 1 && challenge->challengeId == 2 && challenge->challenge == 3);
+}
+
+int main() {
+    testNumbers();
+    testStrings();
+    testStructure();
+    testResponses();
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    std::puts("all checks passed");
+    return 0;
+}
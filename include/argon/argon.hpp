@@ -3,7 +3,12 @@
 #include <Geode/Result.hpp>
 #include <Geode/utils/web.hpp>
 #include <Geode/utils/function.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace argon {
     struct AccountData {
@@ -32,6 +37,59 @@ namespace argon {
     // e.g. "Requesting challenge", "Solving challenge"
     std::string_view authProgressToString(AuthProgress progress);
 
+    // Stages of the authentication that are timed separately, see `AuthSpan`
+    enum class AuthStage {
+        // The whole authentication, from start to finish
+        Total,
+        RequestChallenge,
+        SubmitSolution,
+        // Verifying the solution, including all the polling
+        VerifySolution,
+    };
+
+    std::string_view authStageToString(AuthStage stage);
+
+    // Timing and request details of a single stage of an authentication
+    struct AuthSpan {
+        AuthStage stage;
+        int accountId = 0;
+        std::chrono::system_clock::time_point start;
+        std::chrono::system_clock::time_point end;
+        // Measured with a monotonic clock, unlike the difference of `end` and `start`
+        std::chrono::milliseconds duration{0};
+        // Status code of the last response, -1 if no response was received
+        int httpCode = -1;
+        size_t requests = 0;
+        size_t bytesSent = 0;
+        size_t bytesReceived = 0;
+        size_t retries = 0;
+        size_t pollIterations = 0;
+        bool success = false;
+        // Empty on success
+        std::string error;
+    };
+
+    // Receives every finished span. Can be called from any thread, and from multiple threads at once.
+    using AuthSpanSink = geode::Function<void(const AuthSpan&)>;
+
+    // Sets the sink that receives the spans of every authentication done by this copy of Argon,
+    // pass `nullptr` to remove it. By default there is no sink. Thread-safe.
+    void setAuthSpanSink(AuthSpanSink sink);
+
+    // Latency of a stage across all authentications since the game was started.
+    // Percentiles are approximate, they are accurate to about 20%.
+    struct AuthStageStats {
+        uint64_t count = 0;
+        uint64_t failures = 0;
+        std::chrono::milliseconds p50{0};
+        std::chrono::milliseconds p90{0};
+        std::chrono::milliseconds p99{0};
+        std::chrono::milliseconds max{0};
+    };
+
+    // Returns the latency statistics of a stage, thread-safe.
+    AuthStageStats getAuthStageStats(AuthStage stage);
+
     // Collects the account data of the currently logged in user. Call only on main thread.
     AccountData getGameAccountData();
 
@@ -50,15 +108,142 @@ namespace argon {
     // Get whether certificate verification is enabled
     bool getCertVerification();
 
+    // Connection settings of an Argon server
+    struct ServerConfig {
+        std::string url;
+        bool certVerification = true;
+        std::chrono::milliseconds timeout{10000};
+    };
+
+    // Refers to an Argon server. Tokens are stored separately for every server, and authentications against
+    // different servers can run at the same time. Cheap to copy, thread-safe.
+    class Server {
+    public:
+        // Trailing slashes are removed from the URL
+        static geode::Result<Server> create(ServerConfig config);
+
+        // The server set with `setServerUrl` and `setCertVerification`. Later calls to those don't affect the returned handle.
+        static Server current();
+
+        const ServerConfig& config() const;
+        std::string_view url() const;
+        std::string makeUrl(std::string_view suffix) const;
+
+    private:
+        std::shared_ptr<const ServerConfig> m_config;
+
+        explicit Server(std::shared_ptr<const ServerConfig> config);
+    };
+
+    // Enables or disables background authentication, by default is disabled. When enabled, Argon will start authenticating
+    // the current GD account as soon as your mod is loaded, if there is no cached token for it yet. Any `startAuth` call made
+    // while that is in progress will wait for it instead of starting a new one, and calls made after it will finish instantly.
+    // To take effect, must be called before the mod is loaded, for example in `$execute`.
+    void setBackgroundAuth(bool state);
+
+    // Best-effort warm-up: makes a throwaway request to the Argon server and the GD server in the background. This can get
+    // DNS results and TLS sessions cached, but Argon keeps no connections of its own, so whether a later authentication
+    // gets any faster depends entirely on what Geode's web client reuses. Optional, thread-safe.
+    void prewarm();
+
     /* Starting auth */
 
     using AuthProgressCallback = geode::Function<void(AuthProgress)>;
     using AuthFuture = arc::Future<geode::Result<std::string>>;
 
+    // Can be used to cancel an authentication that is in progress. Copies share the same state, thread-safe.
+    class CancellationToken {
+    public:
+        CancellationToken();
+
+        void cancel();
+        bool cancelled() const;
+
+    private:
+        std::shared_ptr<std::atomic<bool>> m_state;
+    };
+
+    // Controls how often the server is asked whether the challenge has been verified yet
+    struct VerifyPollOptions {
+        // Delay before the first poll. The server may ask for a longer delay, which always takes priority.
+        std::chrono::milliseconds initialDelay{1000};
+        // Upper bound for the delay between two polls
+        std::chrono::milliseconds maxDelay{5000};
+        // Every delay is this many times longer than the previous one
+        double backoffFactor = 1.5;
+        // Every delay is randomly shortened or lengthened by up to this fraction of it
+        double jitter = 0.2;
+        // How long to wait for the verification in total before giving up
+        std::chrono::milliseconds deadline{30000};
+    };
+
+    // Controls how a stage of the authentication is retried after a network error or a server error (5xx or 429).
+    // Other errors, like invalid credentials, are never retried.
+    struct RetryPolicy {
+        // Total amount of attempts including the first one, 1 disables retrying
+        uint32_t maxAttempts = 3;
+        std::chrono::milliseconds initialDelay{500};
+        std::chrono::milliseconds maxDelay{4000};
+        double backoffFactor = 2.0;
+    };
+
+    struct RetryOptions {
+        RetryPolicy request;
+        // Submitting the solution sends a GD message. If the outcome of a failed attempt is unknown,
+        // Argon first checks whether the server has received it before sending another one.
+        RetryPolicy solve{ .maxAttempts = 2 };
+        RetryPolicy verify;
+        // No more retries are started once the authentication has been running for this long
+        std::chrono::milliseconds budget{20000};
+    };
+
+    // How the account proves that it's owned by the user
+    enum class AuthMethod {
+        // Sends a GD message to the server's bot account
+        Message,
+        // Posts a comment on a level chosen by the server
+        Comment,
+        // Uses messages, unless the account can't send any more of them (checked while the challenge is being requested),
+        // or sending the message fails. In both cases falls back to comments.
+        Auto,
+    };
+
+    // Most likely reason why an authentication failed, see `diagnoseAuthFailure`
+    enum class AuthFailureCause {
+        Unknown,
+        InvalidCredentials,
+        MessageLimitReached,
+        // The certificate of a server could not be verified, see `setCertVerification`
+        CertificateError,
+        // The system clock is off by a lot, which also breaks certificate verification
+        ClockSkew,
+        GDServerUnreachable,
+        ArgonServerUnreachable,
+    };
+
+    struct AuthDiagnosis {
+        AuthFailureCause cause = AuthFailureCause::Unknown;
+        // Human readable description, suitable for showing to the user
+        std::string message;
+    };
+
+    using AuthDiagnosisCallback = geode::Function<void(const AuthDiagnosis&)>;
+
     struct AuthOptions  {
         AuthProgressCallback progress;
         AccountData account;
         bool forceStrong = false;
+        // The server may pick a different method than the one requested
+        AuthMethod method = AuthMethod::Message;
+        VerifyPollOptions poll;
+        RetryOptions retry;
+        CancellationToken cancel;
+        // A cached token is only used if it is valid for at least this long. Tokens with unknown expiry are always used.
+        std::chrono::seconds minRemainingLifetime{0};
+        // Called if submitting the solution fails and Argon had to find out why. The returned error is the diagnosis message.
+        AuthDiagnosisCallback diagnosis;
+        // Server to authenticate with, if empty the one returned by `Server::current()` at the time `startAuth` is called
+        std::optional<Server> server;
     };
 
     // Returns a future that will start authentication and return the authtoken once completed.
@@ -68,12 +253,49 @@ namespace argon {
     // Returns a future that will start authentication and return the authtoken once completed.
     AuthFuture startAuth(AuthOptions options);
 
+    struct BulkAuthResult {
+        // Position of the account in `BulkAuthOptions::accounts`
+        size_t index;
+        const AccountData& account;
+        const geode::Result<std::string>& result;
+        // Whether the token was taken from the storage without making any requests
+        bool cached;
+    };
+
+    struct BulkAuthOptions {
+        std::vector<AccountData> accounts;
+        // How many accounts are authenticated at the same time. Accounts with a stored token don't count towards this.
+        size_t maxConcurrent = 4;
+        // Called for every account as soon as it's done, in the order they finish. Never called concurrently.
+        geode::Function<void(const BulkAuthResult&)> onResult;
+        // The rest is applied to every account, see `AuthOptions`
+        bool forceStrong = false;
+        AuthMethod method = AuthMethod::Message;
+        VerifyPollOptions poll;
+        RetryOptions retry;
+        CancellationToken cancel;
+        std::chrono::seconds minRemainingLifetime{0};
+        std::optional<Server> server;
+    };
+
+    // Authenticates many accounts, running at most `maxConcurrent` authentications at a time. Accounts with a usable stored token
+    // are answered right away without any requests. Returns the results in the same order as the accounts. Thread-safe.
+    arc::Future<std::vector<geode::Result<std::string>>> startBulkAuth(BulkAuthOptions options);
+
+    // Checks the GD account, the GD server and the Argon server at the same time, and returns the most likely
+    // reason why authentication isn't working. Takes about as long as the slowest check, at most a few seconds.
+    arc::Future<AuthDiagnosis> diagnoseAuthFailure(AccountData account, Server server = Server::current());
+
     /* Managing tokens */
 
     // Clears all authtokens from the storage that use the same server URL as the current selected.
     // Don't use this unless there's a good reason to. Thread-safe.
     void clearAllTokens();
 
+    // Clears all authtokens from the storage for this server.
+    // Don't use this unless there's a good reason to. Thread-safe.
+    void clearAllTokens(const Server& server);
+
     // Clears all authtokens from the storage for the currently used GD account.
     // Only tokens generated with the same server URL are deleted. Not thread-safe, for thread safety use `(int)` overload.
     void clearToken();
@@ -86,6 +308,9 @@ namespace argon {
     // Only tokens generated with the same server URL are deleted. Thread-safe.
     void clearToken(const AccountData& account);
 
+    // Clears the authtoken for this account and server from the storage, thread-safe.
+    void clearToken(const AccountData& account, const Server& server);
+
     // Checks if there's an authtoken stored for the currently used GD account.
     // Not thread-safe, for thread safety use `(const AccountData&)` overload.
     bool hasToken();
@@ -93,4 +318,58 @@ namespace argon {
     // Checks if there's an authtoken stored for this account, thread-safe.
     // If this returns true, all auth functions will likely immediately return success.
     bool hasToken(const AccountData& account);
+
+    // Checks if there's an authtoken stored for this account and server, thread-safe.
+    bool hasToken(const AccountData& account, const Server& server);
+
+    struct TokenInfo {
+        std::string token;
+        // Unix timestamps in seconds, 0 if unknown
+        int64_t issuedAt = 0;
+        int64_t expiresAt = 0;
+        int64_t lastValidated = 0;
+    };
+
+    // Returns the stored authtoken for this account along with its metadata, thread-safe.
+    std::optional<TokenInfo> getTokenInfo(const AccountData& account);
+    std::optional<TokenInfo> getTokenInfo(const AccountData& account, const Server& server);
+
+    // Records that the authtoken for this account was just accepted by your server, thread-safe.
+    void markTokenValidated(const AccountData& account);
+    void markTokenValidated(const AccountData& account, const Server& server);
+
+    // Sets how long tokens are assumed to be valid for when the server does not say, thread-safe.
+    // By default is 0, which means tokens are assumed to never expire. The official server does not report token expiry,
+    // so this should match how long your server accepts tokens for.
+    void setDefaultTokenLifetime(std::chrono::seconds lifetime);
+
+    // Enables or disables automatic token refreshing, by default is disabled. When enabled, Argon will periodically check the tokens
+    // of every account authenticated since, each on the server it was authenticated against, and re-authenticate them in the background
+    // once they're less than `margin` away from expiring. Only has an effect on tokens with known expiry, which unless your server
+    // reports it means that `setDefaultTokenLifetime` has to be called first. Thread-safe.
+    void setTokenRefresh(bool enabled, std::chrono::seconds margin = std::chrono::hours(1));
+
+    // Counters for the work done by this copy of Argon since the game was started.
+    // Mostly useful for testing against a local server, to see how many requests each authentication costs.
+    struct AuthStats {
+        // Authentications that had to go through the whole challenge flow
+        uint64_t started = 0;
+        uint64_t succeeded = 0;
+        uint64_t failed = 0;
+        // `startAuth` calls that were answered with a stored token
+        uint64_t cached = 0;
+        // `startAuth` calls that waited for another authentication of the same account
+        uint64_t joined = 0;
+        uint64_t argonRequests = 0;
+        uint64_t gdRequests = 0;
+    };
+
+    // Returns the counters, thread-safe.
+    AuthStats getAuthStats();
+
+    // Enables or disables the compact binary token storage, by default is disabled.
+    // It only makes loading the stored tokens faster, once loaded they are kept in memory either way.
+    // The JSON storage file is still kept up to date, so older versions of Argon keep working.
+    // This setting is shared between all mods that use Argon. Thread-safe.
+    void setBinaryStorage(bool state);
 }
@@ -0,0 +1,20 @@
+#pragma once
+
+#ifdef ARGON_SERVER_HAS_CURL
+
+#include <argon/core/Transport.hpp>
+
+namespace argon::server {
+
+// `core::HttpTransport` implementation on top of libcurl. Each thread reuses its own handle, so connections to the
+// Argon server are kept alive between requests made from the same thread.
+class CurlTransport : public core::HttpTransport {
+public:
+    CurlTransport();
+
+    core::HttpResponse send(const core::HttpRequest& request) override;
+};
+
+}
+
+#endif
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <argon/core/Transport.hpp>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <stdint.h>
+
+namespace argon::server {
+
+struct ValidationResult {
+    // Set if the token could not be checked at all (network error, unexpected response),
+    // in which case none of the other fields are meaningful and the result is not cached
+    std::optional<std::string> error;
+
+    bool valid = false;
+    // Strong checks only, whether the token is valid ignoring the username
+    bool validWeak = false;
+    // Reason why the token is invalid, if provided by the server
+    std::string cause;
+    // Strong checks only, the actual username of the account
+    std::string username;
+
+    // Whether this result was served from the cache or by joining another in-flight check
+    bool cached = false;
+
+    bool ok() const {
+        return !error.has_value();
+    }
+};
+
+// Groups checks that arrive close together into a single request. This helps a lot when many players
+// connect at once (e.g. after a server restart), at the cost of up to `maxDelay` of added latency per check.
+// The official Argon server has no batch endpoints, this is only for servers that implement them.
+struct BatchOptions {
+    bool enabled = false;
+
+    // A batch is sent as soon as it has this many checks, or once its oldest check has waited for `maxDelay`
+    size_t maxBatchSize = 100;
+    std::chrono::milliseconds maxDelay{20};
+
+    // How many batches of each kind can be in flight at once
+    size_t maxConcurrentBatches = 2;
+
+    // Endpoints relative to the base URL. They take a JSON array of checks and return a JSON array of verdicts in the same order.
+    // Both are probed with an empty array when the validator is constructed, batching is only used for the ones that answer
+    // with an empty array. If an endpoint disappears later (404), the validator falls back to one request per token.
+    std::string checkPath = "v1/validation/check_many";
+    std::string checkStrongPath = "v1/validation/check_strong_many";
+};
+
+struct ValidatorOptions {
+    std::string baseUrl = "https://argon.globed.dev";
+    // Per request, including batched ones
+    std::chrono::milliseconds timeout{10000};
+
+    // How long valid and invalid verdicts are remembered for
+    std::chrono::seconds validTtl{300};
+    std::chrono::seconds invalidTtl{30};
+
+    // Total amount of remembered verdicts, split evenly between shards
+    size_t cacheCapacity = 65536;
+    // More shards means less lock contention between threads validating different tokens
+    size_t shardCount = 16;
+
+    BatchOptions batching;
+};
+
+struct ValidatorStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Checks that waited for an identical check already in progress instead of making a request
+    uint64_t coalesced = 0;
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    // Batched requests, these are also counted in `requests`
+    uint64_t batches = 0;
+    // Whether the batch endpoints were found when the validator was constructed
+    bool batchingAvailable = false;
+    bool strongBatchingAvailable = false;
+};
+
+// Validates Argon tokens on the server side, see https://github.com/GlobedGD/argon-server/blob/main/docs/server-api.md
+// Verdicts are cached, and concurrent checks of the same token only result in one request. Thread-safe.
+class Validator {
+public:
+    // If batching is enabled, this makes a request to find out whether the server supports it
+    Validator(std::shared_ptr<core::HttpTransport> transport, ValidatorOptions options = {});
+    ~Validator();
+
+    Validator(const Validator&) = delete;
+    Validator& operator=(const Validator&) = delete;
+
+    // Checks whether the token is valid for this account, `v1/validation/check`
+    ValidationResult check(int accountId, std::string_view token);
+
+    // Checks whether the token is valid for this account and the username matches, `v1/validation/check_strong`
+    ValidationResult checkStrong(int accountId, int userId, std::string_view username, std::string_view token);
+
+    // Forgets all cached verdicts
+    void clearCache();
+
+    ValidatorStats stats() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+}
@@ -0,0 +1,112 @@
+#include "Batcher.hpp"
+#include <algorithm>
+
+namespace argon::server {
+
+Batcher::Batcher(const BatchOptions& options, SendFn send)
+    : m_maxBatchSize(std::max<size_t>(options.maxBatchSize, 1)),
+      m_maxDelay(options.maxDelay),
+      m_send(std::move(send))
+{
+    size_t workers = std::max<size_t>(options.maxConcurrentBatches, 1);
+
+    for (size_t i = 0; i < workers; i++) {
+        m_workers.emplace_back([this] { this->workerLoop(); });
+    }
+}
+
+Batcher::~Batcher() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_cv.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+std::future<ValidationResult> Batcher::submit(BatchItem item) {
+    auto future = item.promise.get_future();
+    bool full;
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_queue.push_back(Queued { .item = std::move(item), .queuedAt = Clock::now() });
+        full = m_queue.size() >= m_maxBatchSize;
+    }
+
+    // a full batch must wake up whoever is waiting for it to fill, not just any worker
+    if (full) {
+        m_cv.notify_all();
+    } else {
+        m_cv.notify_one();
+    }
+
+    return future;
+}
+
+void Batcher::workerLoop() {
+    std::unique_lock lock(m_mutex);
+
+    while (true) {
+        m_cv.wait(lock, [&] { return m_stopping || !m_queue.empty(); });
+
+        if (m_queue.empty()) {
+            // stopping and nothing left to send
+            return;
+        }
+
+        // wait for the batch to fill up, but not longer than the oldest check is allowed to wait
+        auto sendBy = m_queue.front().queuedAt + m_maxDelay;
+        m_cv.wait_until(lock, sendBy, [&] {
+            return m_stopping || m_queue.empty() || m_queue.size() >= m_maxBatchSize;
+        });
+
+        // another worker may have taken the batch while we were waiting
+        if (m_queue.empty()) continue;
+
+        size_t count = std::min(m_queue.size(), m_maxBatchSize);
+
+        std::vector<BatchItem> batch;
+        batch.reserve(count);
+
+        for (size_t i = 0; i < count; i++) {
+            batch.push_back(std::move(m_queue.front().item));
+            m_queue.pop_front();
+        }
+
+        // let another worker start collecting the next batch
+        if (!m_queue.empty()) {
+            m_cv.notify_one();
+        }
+
+        lock.unlock();
+
+        std::vector<ValidationResult> results;
+        try {
+            results = m_send(batch);
+        } catch (const std::exception& e) {
+            results.clear();
+            ValidationResult err;
+            err.error = std::string{"Request error: "} + e.what();
+            results.resize(batch.size(), err);
+        }
+
+        if (results.size() != batch.size()) {
+            ValidationResult err;
+            err.error = "Batched validation returned the wrong amount of results";
+            results.assign(batch.size(), err);
+        }
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            batch[i].promise.set_value(std::move(results[i]));
+        }
+
+        lock.lock();
+    }
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <argon/server/Validator.hpp>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace argon::server {
+
+struct BatchItem {
+    int accountId = 0;
+    int userId = 0;
+    std::string username{};
+    std::string token{};
+    std::promise<ValidationResult> promise{};
+};
+
+// Collects checks of one kind and hands them off in batches to `send`, from a few worker threads
+class Batcher {
+public:
+    // Must return exactly one result per item, in the same order
+    using SendFn = std::function<std::vector<ValidationResult>(const std::vector<BatchItem>&)>;
+
+    Batcher(const BatchOptions& options, SendFn send);
+    ~Batcher();
+
+    Batcher(const Batcher&) = delete;
+    Batcher& operator=(const Batcher&) = delete;
+
+    std::future<ValidationResult> submit(BatchItem item);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Queued {
+        BatchItem item;
+        Clock::time_point queuedAt;
+    };
+
+    size_t m_maxBatchSize;
+    Clock::duration m_maxDelay;
+    SendFn m_send;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Queued> m_queue;
+    bool m_stopping = false;
+    std::vector<std::thread> m_workers;
+
+    void workerLoop();
+};
+
+}
@@ -0,0 +1,86 @@
+#include <argon/server/CurlTransport.hpp>
+#include <curl/curl.h>
+#include <memory>
+#include <mutex>
+
+namespace argon::server {
+
+static size_t writeCallback(char* data, size_t size, size_t count, void* userdata) {
+    static_cast<std::string*>(userdata)->append(data, size * count);
+    return size * count;
+}
+
+using core::HttpMethod;
+using core::HttpRequest;
+using core::HttpResponse;
+
+CurlTransport::CurlTransport() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+    });
+}
+
+HttpResponse CurlTransport::send(const HttpRequest& request) {
+    struct HandleDeleter {
+        void operator()(CURL* handle) const {
+            curl_easy_cleanup(handle);
+        }
+    };
+
+    thread_local std::unique_ptr<CURL, HandleDeleter> handle{curl_easy_init()};
+
+    HttpResponse response;
+
+    if (!handle) {
+        response.error = "failed to create curl handle";
+        return response;
+    }
+
+    auto curl = handle.get();
+    curl_easy_reset(curl);
+
+    char errbuf[CURL_ERROR_SIZE] = {0};
+
+    curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, errbuf);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long) request.timeout.count());
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "argon-server/" ARGON_SERVER_VERSION);
+
+    struct SlistDeleter {
+        void operator()(curl_slist* list) const {
+            curl_slist_free_all(list);
+        }
+    };
+
+    std::unique_ptr<curl_slist, SlistDeleter> headers;
+
+    if (request.method == HttpMethod::Post) {
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.body.data());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long) request.body.size());
+
+        // without one curl sends the form encoded content type, which is what GD servers expect anyway
+        if (!request.contentType.empty()) {
+            headers.reset(curl_slist_append(nullptr, ("Content-Type: " + request.contentType).c_str()));
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers.get());
+        }
+    }
+
+    auto res = curl_easy_perform(curl);
+    if (res != CURLE_OK) {
+        response.error = errbuf[0] ? errbuf : curl_easy_strerror(res);
+        return response;
+    }
+
+    long code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+    response.code = (int) code;
+
+    return response;
+}
+
+}
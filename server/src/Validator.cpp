@@ -0,0 +1,342 @@
+#include <argon/server/Validator.hpp>
+#include "Batcher.hpp"
+#include "VerdictCache.hpp"
+#include <argon/core/Protocol.hpp>
+#include <argon/core/Text.hpp>
+
+#include <atomic>
+
+namespace argon::server {
+
+using core::HttpMethod;
+using core::HttpRequest;
+using core::HttpResponse;
+using core::HttpTransport;
+
+static std::string urlEncode(std::string_view str) {
+    static constexpr char HEX[] = "0123456789ABCDEF";
+
+    std::string out;
+    out.reserve(str.size());
+
+    for (unsigned char c : str) {
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~') {
+            out.push_back(c);
+        } else {
+            out.push_back('%');
+            out.push_back(HEX[c >> 4]);
+            out.push_back(HEX[c & 0xf]);
+        }
+    }
+
+    return out;
+}
+
+static ValidationResult makeError(std::string message) {
+    ValidationResult result;
+    result.error = std::move(message);
+    return result;
+}
+
+static ValidationResult toResult(core::Expected<core::ValidationVerdict>&& verdict) {
+    if (!verdict) {
+        return makeError(std::move(verdict).error());
+    }
+
+    ValidationResult result;
+    result.valid = verdict->valid;
+    result.validWeak = verdict->validWeak;
+    result.cause = std::move(verdict->cause);
+    result.username = std::move(verdict->username);
+
+    return result;
+}
+
+static std::optional<ValidationResult> checkResponseStatus(const HttpResponse& response) {
+    if (response.code == -1) {
+        return makeError("Request error: " + core::truncate(response.error.empty() ? "(unknown error)" : response.error));
+    }
+
+    if (response.code != 200) {
+        return makeError("Error from argon (code " + std::to_string(response.code) + "): " + core::truncate(response.body));
+    }
+
+    return std::nullopt;
+}
+
+static ValidationResult parseResponse(const HttpResponse& response, bool strong) {
+    if (auto err = checkResponseStatus(response)) {
+        return std::move(*err);
+    }
+
+    return toResult(core::decodeValidationCheck(response.body, strong));
+}
+
+class Validator::Impl {
+public:
+    Impl(std::shared_ptr<HttpTransport> transport, ValidatorOptions options)
+        : m_transport(std::move(transport)),
+          m_options(std::move(options)),
+          m_cache(m_options.cacheCapacity, m_options.shardCount)
+    {
+        // strip trailing slash
+        while (!m_options.baseUrl.empty() && m_options.baseUrl.back() == '/') {
+            m_options.baseUrl.pop_back();
+        }
+
+        // batch endpoints are not part of the official API, only use them if the server has them
+        if (m_options.batching.enabled && this->probeBatching(false)) {
+            m_weakBatcher = std::make_unique<Batcher>(m_options.batching, [this](const std::vector<BatchItem>& items) {
+                return this->sendBatch(items, false);
+            });
+        }
+
+        if (m_options.batching.enabled && this->probeBatching(true)) {
+            m_strongBatcher = std::make_unique<Batcher>(m_options.batching, [this](const std::vector<BatchItem>& items) {
+                return this->sendBatch(items, true);
+            });
+        }
+    }
+
+    ~Impl() {
+        // stop the batchers first, their threads call back into us
+        m_weakBatcher.reset();
+        m_strongBatcher.reset();
+    }
+
+    ValidationResult check(const std::string& key, const std::string& url, bool strong, BatchItem item) {
+        auto lookup = m_cache.lookup(key);
+
+        if (lookup.result) {
+            m_hits++;
+            lookup.result->cached = true;
+            return std::move(*lookup.result);
+        }
+
+        if (lookup.pending) {
+            m_coalesced++;
+            auto result = lookup.pending->get();
+            result.cached = true;
+            return result;
+        }
+
+        m_misses++;
+
+        ValidationResult result;
+        auto& batcher = strong ? m_strongBatcher : m_weakBatcher;
+
+        if (batcher && !m_batchingUnsupported.load(std::memory_order::relaxed)) {
+            result = batcher->submit(std::move(item)).get();
+        } else {
+            result = this->checkSingle(url, strong);
+        }
+
+        // errors are never cached, the next check should try again
+        VerdictCache::Clock::duration ttl{};
+        if (!result.ok()) {
+            m_errors++;
+        } else if (strong ? result.validWeak : result.valid) {
+            ttl = m_options.validTtl;
+        } else {
+            ttl = m_options.invalidTtl;
+        }
+
+        m_cache.complete(key, std::move(*lookup.leader), result, ttl);
+
+        return result;
+    }
+
+    HttpResponse get(const std::string& url) {
+        return m_transport->send(HttpRequest {
+            .method = HttpMethod::Get,
+            .url = url,
+            .body = {},
+            .contentType = {},
+            .timeout = m_options.timeout,
+        });
+    }
+
+    HttpResponse postJson(const std::string& url, std::string body) {
+        return m_transport->send(HttpRequest {
+            .method = HttpMethod::Post,
+            .url = url,
+            .body = std::move(body),
+            .contentType = "application/json",
+            .timeout = m_options.timeout,
+        });
+    }
+
+    ValidationResult checkSingle(const std::string& url, bool strong) {
+        m_requests++;
+
+        try {
+            return parseResponse(this->get(url), strong);
+        } catch (const std::exception& e) {
+            return makeError(std::string{"Request error: "} + e.what());
+        }
+    }
+
+    // Sends an empty batch, a server that supports batching answers with an empty array
+    bool probeBatching(bool strong) {
+        auto& path = strong ? m_options.batching.checkStrongPath : m_options.batching.checkPath;
+
+        HttpResponse response;
+        try {
+            response = this->postJson(m_options.baseUrl + "/" + path, "[]");
+        } catch (const std::exception&) {
+            return false;
+        }
+
+        if (response.code != 200) {
+            return false;
+        }
+
+        auto verdicts = core::decodeValidationCheckBatch(response.body, strong);
+        return verdicts && verdicts->empty();
+    }
+
+    std::vector<ValidationResult> sendBatch(const std::vector<BatchItem>& items, bool strong) {
+        std::string body = "[";
+
+        for (auto& item : items) {
+            if (body.size() > 1) body.push_back(',');
+
+            body += "{\"account_id\":" + std::to_string(item.accountId);
+
+            if (strong) {
+                body += ",\"user_id\":" + std::to_string(item.userId);
+                body += ",\"username\":";
+                core::appendJsonString(body, item.username);
+            }
+
+            body += ",\"authtoken\":";
+            core::appendJsonString(body, item.token);
+            body.push_back('}');
+        }
+
+        body.push_back(']');
+
+        auto& path = strong ? m_options.batching.checkStrongPath : m_options.batching.checkPath;
+
+        m_requests++;
+        m_batches++;
+        auto response = this->postJson(m_options.baseUrl + "/" + path, std::move(body));
+
+        // server (or transport) doesn't support batching, don't try again and check these one by one
+        if (response.code == 404 || response.code == 405 || response.code == 501) {
+            m_batchingUnsupported = true;
+
+            std::vector<ValidationResult> results;
+            results.reserve(items.size());
+
+            for (auto& item : items) {
+                results.push_back(this->checkSingle(strong
+                    ? this->strongUrl(item.accountId, item.userId, item.username, item.token)
+                    : this->weakUrl(item.accountId, item.token), strong));
+            }
+
+            return results;
+        }
+
+        if (auto err = checkResponseStatus(response)) {
+            return std::vector<ValidationResult>(items.size(), *err);
+        }
+
+        auto verdicts = core::decodeValidationCheckBatch(response.body, strong);
+        if (!verdicts || verdicts->size() != items.size()) {
+            return std::vector<ValidationResult>(items.size(), makeError("Malformed server response: " + core::truncate(response.body)));
+        }
+
+        std::vector<ValidationResult> results;
+        results.reserve(items.size());
+
+        for (auto& verdict : *verdicts) {
+            results.push_back(toResult(std::move(verdict)));
+        }
+
+        return results;
+    }
+
+    std::string weakUrl(int accountId, std::string_view token) const {
+        return m_options.baseUrl + "/v1/validation/check?account_id=" + std::to_string(accountId) + "&authtoken=" + urlEncode(token);
+    }
+
+    std::string strongUrl(int accountId, int userId, std::string_view username, std::string_view token) const {
+        return m_options.baseUrl + "/v1/validation/check_strong?account_id=" + std::to_string(accountId)
+            + "&user_id=" + std::to_string(userId)
+            + "&username=" + urlEncode(username)
+            + "&authtoken=" + urlEncode(token);
+    }
+
+    const ValidatorOptions& options() const {
+        return m_options;
+    }
+
+    void clearCache() {
+        m_cache.clear();
+    }
+
+    ValidatorStats stats() const {
+        return ValidatorStats {
+            .hits = m_hits.load(std::memory_order::relaxed),
+            .misses = m_misses.load(std::memory_order::relaxed),
+            .coalesced = m_coalesced.load(std::memory_order::relaxed),
+            .requests = m_requests.load(std::memory_order::relaxed),
+            .errors = m_errors.load(std::memory_order::relaxed),
+            .batches = m_batches.load(std::memory_order::relaxed),
+            .batchingAvailable = m_weakBatcher != nullptr,
+            .strongBatchingAvailable = m_strongBatcher != nullptr,
+        };
+    }
+
+private:
+    std::shared_ptr<HttpTransport> m_transport;
+    ValidatorOptions m_options;
+    VerdictCache m_cache;
+
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_coalesced{0};
+    std::atomic<uint64_t> m_requests{0};
+    std::atomic<uint64_t> m_errors{0};
+    std::atomic<uint64_t> m_batches{0};
+
+    std::unique_ptr<Batcher> m_weakBatcher;
+    std::unique_ptr<Batcher> m_strongBatcher;
+    std::atomic<bool> m_batchingUnsupported{false};
+};
+
+Validator::Validator(std::shared_ptr<HttpTransport> transport, ValidatorOptions options)
+    : m_impl(std::make_unique<Impl>(std::move(transport), std::move(options))) {}
+
+Validator::~Validator() = default;
+
+ValidationResult Validator::check(int accountId, std::string_view token) {
+    auto key = "w\n" + std::to_string(accountId) + "\n" + std::string{token};
+
+    return m_impl->check(key, m_impl->weakUrl(accountId, token), false, BatchItem {
+        .accountId = accountId,
+        .token = std::string{token},
+    });
+}
+
+ValidationResult Validator::checkStrong(int accountId, int userId, std::string_view username, std::string_view token) {
+    auto key = "s\n" + std::to_string(accountId) + "\n" + std::to_string(userId) + "\n" + std::string{username} + "\n" + std::string{token};
+
+    return m_impl->check(key, m_impl->strongUrl(accountId, userId, username, token), true, BatchItem {
+        .accountId = accountId,
+        .userId = userId,
+        .username = std::string{username},
+        .token = std::string{token},
+    });
+}
+
+void Validator::clearCache() {
+    m_impl->clearCache();
+}
+
+ValidatorStats Validator::stats() const {
+    return m_impl->stats();
+}
+
+}
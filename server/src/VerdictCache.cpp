@@ -0,0 +1,86 @@
+#include "VerdictCache.hpp"
+#include <algorithm>
+
+namespace argon::server {
+
+VerdictCache::VerdictCache(size_t capacity, size_t shardCount) {
+    shardCount = std::max<size_t>(shardCount, 1);
+    m_shardCapacity = std::max<size_t>(capacity / shardCount, 1);
+
+    m_shards.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; i++) {
+        m_shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+VerdictCache::Shard& VerdictCache::shardFor(const std::string& key) {
+    return *m_shards[std::hash<std::string>{}(key) % m_shards.size()];
+}
+
+VerdictCache::Lookup VerdictCache::lookup(const std::string& key) {
+    auto& shard = this->shardFor(key);
+    std::lock_guard lock(shard.mutex);
+
+    if (auto it = shard.entries.find(key); it != shard.entries.end()) {
+        auto entry = it->second;
+
+        if (entry->expiresAt > Clock::now()) {
+            // bump to the front
+            shard.lru.splice(shard.lru.begin(), shard.lru, entry);
+            return Lookup { .result = entry->result };
+        }
+
+        shard.lru.erase(entry);
+        shard.entries.erase(it);
+    }
+
+    if (auto it = shard.pending.find(key); it != shard.pending.end()) {
+        return Lookup { .pending = it->second };
+    }
+
+    std::promise<ValidationResult> promise;
+    shard.pending.emplace(key, promise.get_future().share());
+
+    return Lookup { .leader = std::move(promise) };
+}
+
+void VerdictCache::complete(const std::string& key, std::promise<ValidationResult> promise, const ValidationResult& result, Clock::duration ttl) {
+    auto& shard = this->shardFor(key);
+
+    {
+        std::lock_guard lock(shard.mutex);
+
+        shard.pending.erase(key);
+
+        if (ttl > Clock::duration::zero()) {
+            if (auto it = shard.entries.find(key); it != shard.entries.end()) {
+                shard.lru.erase(it->second);
+                shard.entries.erase(it);
+            }
+
+            shard.lru.push_front(Entry {
+                .key = key,
+                .result = result,
+                .expiresAt = Clock::now() + ttl,
+            });
+            shard.entries.emplace(key, shard.lru.begin());
+
+            while (shard.lru.size() > m_shardCapacity) {
+                shard.entries.erase(shard.lru.back().key);
+                shard.lru.pop_back();
+            }
+        }
+    }
+
+    promise.set_value(result);
+}
+
+void VerdictCache::clear() {
+    for (auto& shard : m_shards) {
+        std::lock_guard lock(shard->mutex);
+        shard->lru.clear();
+        shard->entries.clear();
+    }
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <argon/server/Validator.hpp>
+#include <chrono>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace argon::server {
+
+// Sharded LRU cache of validation verdicts with per-entry expiry, which also keeps track of checks in progress
+// so that concurrent checks of the same token can wait for the first one instead of making their own request.
+class VerdictCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    VerdictCache(size_t capacity, size_t shardCount);
+
+    // Outcome of looking up a key, exactly one of the members is set
+    struct Lookup {
+        // Cached verdict
+        std::optional<ValidationResult> result{};
+        // Someone else is already checking this key, wait on this
+        std::optional<std::shared_future<ValidationResult>> pending{};
+        // Nobody is checking this key, the caller must do it and then call `complete`
+        std::optional<std::promise<ValidationResult>> leader{};
+    };
+
+    Lookup lookup(const std::string& key);
+
+    // Publishes the result to everyone waiting on the key, and caches it for `ttl` if it's nonzero
+    void complete(const std::string& key, std::promise<ValidationResult> promise, const ValidationResult& result, Clock::duration ttl);
+
+    void clear();
+
+private:
+    struct Entry {
+        std::string key;
+        ValidationResult result;
+        Clock::time_point expiresAt;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru; // most recently used first
+        std::unordered_map<std::string, std::list<Entry>::iterator> entries;
+        std::unordered_map<std::string, std::shared_future<ValidationResult>> pending;
+    };
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    size_t m_shardCapacity;
+
+    Shard& shardFor(const std::string& key);
+};
+
+}
@@ -1,6 +1,7 @@
 #include "ArgonState.hpp"
 #include "Web.hpp"
 #include "ArgonStorage.hpp"
+#include "CleanupQueue.hpp"
 #include <Geode/binding/GameManager.hpp>
 
 using enum std::memory_order;
@@ -11,35 +12,126 @@ ArgonState::ArgonState() {
     this->setServerUrl("https://argon.globed.dev");
 }
 
-void ArgonState::setServerUrl(std::string url) {
-    auto lock = m_serverUrl.lock();
+template <typename F>
+void ArgonState::updateConfig(F&& update) {
+    std::lock_guard lock{m_configWriteMutex};
+
+    auto current = this->config();
+    auto next = std::make_shared<ConfigSnapshot>(current ? *current : ConfigSnapshot{});
+    update(*next);
+
+#ifdef __cpp_lib_atomic_shared_ptr
+    m_config.store(std::move(next), release);
+#else
+    std::atomic_store_explicit(&m_config, std::shared_ptr<const ConfigSnapshot>{std::move(next)}, release);
+#endif
+}
 
-    *lock = std::move(url);
+std::shared_ptr<const ConfigSnapshot> ArgonState::config() const {
+#ifdef __cpp_lib_atomic_shared_ptr
+    return m_config.load(acquire);
+#else
+    return std::atomic_load_explicit(&m_config, acquire);
+#endif
+}
 
+void ArgonState::setServerUrl(std::string url) {
     // Strip trailing slash
-    while (!lock->empty() && lock->back() == '/') {
-        lock->pop_back();
+    while (!url.empty() && url.back() == '/') {
+        url.pop_back();
     }
+
+    this->updateConfig([&](ConfigSnapshot& config) {
+        config.server.url = std::move(url);
+    });
 }
 
 std::string ArgonState::getServerUrl() const {
-    return *m_serverUrl.lock();
+    return this->config()->server.url;
+}
+
+void ArgonState::setCertVerification(bool state) {
+    this->updateConfig([&](ConfigSnapshot& config) {
+        config.server.certVerification = state;
+    });
+}
+
+bool ArgonState::getCertVerification() const {
+    return this->config()->server.certVerification;
+}
+
+void ArgonState::setBackgroundAuth(bool state) {
+    m_backgroundAuth = state;
+}
+
+bool ArgonState::getBackgroundAuth() const {
+    return m_backgroundAuth.load();
+}
+
+void ArgonState::setDefaultTokenLifetime(int64_t secs) {
+    m_defaultTokenLifetime = secs;
+}
+
+bool ArgonState::hasDefaultTokenLifetime() const {
+    return m_defaultTokenLifetime.load() > 0;
 }
 
-std::string ArgonState::makeUrl(std::string_view suffix) const {
-    while (suffix.starts_with('/')) {
-        suffix.remove_prefix(1);
+int64_t ArgonState::computeExpiry(int64_t expiresIn) const {
+    // server knows best, fall back to the configured lifetime if it didn't tell us
+    if (expiresIn <= 0) {
+        expiresIn = m_defaultTokenLifetime.load();
+    }
+
+    if (expiresIn <= 0) {
+        return 0;
     }
 
-    return fmt::format("{}/{}", getServerUrl(), suffix);
+    return unixTimestamp() + expiresIn;
 }
 
-void ArgonState::setCertVerification(bool state) {
-    m_certVerification = state;
+void ArgonState::setRefreshMargin(int64_t secs) {
+    m_refreshMargin = secs;
 }
 
-bool ArgonState::getCertVerification() const {
-    return m_certVerification.load();
+int64_t ArgonState::getRefreshMargin() const {
+    return m_refreshMargin.load();
+}
+
+static bool isSameRefreshEntry(const ArgonState::RefreshEntry& entry, const AccountData& account, std::string_view serverUrl) {
+    return entry.account.accountId == account.accountId
+        && entry.account.userId == account.userId
+        && entry.server.url() == serverUrl;
+}
+
+void ArgonState::addRefreshEntry(const AccountData& account, const Server& server) {
+    auto entries = m_refreshEntries.lock();
+
+    for (auto& entry : *entries) {
+        if (isSameRefreshEntry(entry, account, server.url())) {
+            entry = RefreshEntry{account, server};
+            return;
+        }
+    }
+
+    entries->push_back(RefreshEntry{account, server});
+}
+
+void ArgonState::removeRefreshEntry(const AccountData& account, std::string_view serverUrl) {
+    std::erase_if(*m_refreshEntries.lock(), [&](const RefreshEntry& entry) {
+        return isSameRefreshEntry(entry, account, serverUrl);
+    });
+}
+
+std::vector<ArgonState::RefreshEntry> ArgonState::getRefreshEntries() const {
+    return *m_refreshEntries.lock();
+}
+
+bool ArgonState::tryStartRefresher() {
+    return !m_refresherRunning.exchange(true);
+}
+
+void ArgonState::refresherStopped() {
+    m_refresherRunning = false;
 }
 
 std::lock_guard<std::mutex> ArgonState::acquireConfigLock() {
@@ -53,21 +145,64 @@ std::lock_guard<std::mutex> ArgonState::acquireConfigLock() {
     return std::lock_guard(*ptr);
 }
 
+// Other copies of argon keep raw pointers into everything published here for the rest of the game,
+// so a published object is retained forever and never replaced. Changing the layout of a shared struct means
+// a new key, so anything unexpected under a key is left alone, and this copy keeps a private object instead.
+template <typename T>
+static T* getOrPublish(GameManager* gm, const std::string& key) {
+    auto existing = gm->getUserObject(key);
+
+    if (auto obj = geode::cast::typeinfo_cast<CCData<T>*>(existing); obj && obj->data().version == T::VERSION) {
+        return &obj->data();
+    }
+
+    auto obj = CCData<T>::create();
+    obj->retain();
+
+    if (existing) {
+        log::warn("(Argon) {} holds an incompatible object, not sharing it with other mods", key);
+    } else {
+        gm->setUserObject(key, obj);
+    }
+
+    return &obj->data();
+}
+
 void ArgonState::initConfigLock() {
     if (m_configLock.load(acquire)) return;
 
     // note: this function is horrible and really has to be thread safe :)
 
     static const std::string LOCK_KEY = "dankmeme.argon/_config_lock_v2_25ea8834";
+    static const std::string TABLE_KEY = "dankmeme.argon/_token_table_v1_5be0c7d4";
+    static const std::string FLIGHTS_KEY = "dankmeme.argon/_auth_flights_v1_61a9e3f5";
+    static const std::string SCHEDULER_KEY = "dankmeme.argon/_request_scheduler_v1_7c4e0b19";
 
     auto gm = GameManager::get();
 
-    auto lockobj = geode::cast::typeinfo_cast<CCMutex*>(gm->getUserObject(LOCK_KEY));
+    auto existingLock = gm->getUserObject(LOCK_KEY);
+    auto lockobj = geode::cast::typeinfo_cast<CCMutex*>(existingLock);
     if (!lockobj) {
         lockobj = CCMutex::create();
-        gm->setUserObject(LOCK_KEY, lockobj);
+        lockobj->retain();
+
+        if (existingLock) {
+            log::warn("(Argon) {} holds an incompatible object, not sharing it with other mods", LOCK_KEY);
+        } else {
+            gm->setUserObject(LOCK_KEY, lockobj);
+        }
     }
 
+    // the first copy of argon to get here creates the token table, everyone else reuses it,
+    // so the data file only has to be parsed once no matter how many mods use argon
+    auto table = getOrPublish<SharedTokenTable>(gm, TABLE_KEY);
+    auto flights = getOrPublish<SharedAuthFlights>(gm, FLIGHTS_KEY);
+    auto scheduler = getOrPublish<SharedRequestScheduler>(gm, SCHEDULER_KEY);
+
+    // publish the shared state before the lock, anyone who sees the lock must also see the rest
+    m_tokenTable.store(table, release);
+    m_authFlights.store(flights, release);
+    m_requestScheduler.store(scheduler, release);
     m_configLock.store(&lockobj->data(), release);
 }
 
@@ -75,23 +210,77 @@ bool ArgonState::isConfigLockInitialized() {
     return m_configLock.load(acquire) != nullptr;
 }
 
-void ArgonState::handleSuccessfulAuth(AccountData account, std::string authToken, std::string serverIdent, int commentId) {
-    arc::spawn([
-        account = std::move(account),
-        authToken = std::move(authToken),
-        serverIdent = std::move(serverIdent),
-        commentId
-    ](this auto self) -> arc::Future<> {
-        // save authtoken
-        if (auto err = ArgonStorage::get().storeAuthToken(account, serverIdent, authToken).err()) {
-            log::warn("(Argon) failed to save authtoken: {}", *err);
-        }
+SharedTokenTable& ArgonState::getTokenTable() {
+    auto ptr = m_tokenTable.load(acquire);
 
-        // don't care if the message deletion fails
-        if (commentId != 0) {
-            (void) co_await web::deleteGDMessage(account, commentId);
-        }
-    });
+    if (!ptr) {
+        this->initConfigLock();
+        ptr = m_tokenTable.load(acquire);
+    }
+
+    return *ptr;
+}
+
+SharedAuthFlights& ArgonState::getAuthFlights() {
+    auto ptr = m_authFlights.load(acquire);
+
+    if (!ptr) {
+        this->initConfigLock();
+        ptr = m_authFlights.load(acquire);
+    }
+
+    return *ptr;
+}
+
+SharedRequestScheduler& ArgonState::getRequestScheduler() {
+    auto ptr = m_requestScheduler.load(acquire);
+
+    if (!ptr) {
+        this->initConfigLock();
+        ptr = m_requestScheduler.load(acquire);
+    }
+
+    return *ptr;
+}
+
+ArgonState::Counters& ArgonState::counters() {
+    return m_counters;
+}
+
+AuthStats ArgonState::getStats() const {
+    return AuthStats {
+        .started = m_counters.started.load(relaxed),
+        .succeeded = m_counters.succeeded.load(relaxed),
+        .failed = m_counters.failed.load(relaxed),
+        .cached = m_counters.cached.load(relaxed),
+        .joined = m_counters.joined.load(relaxed),
+        .argonRequests = m_counters.argonRequests.load(relaxed),
+        .gdRequests = m_counters.gdRequests.load(relaxed),
+    };
+}
+
+void ArgonState::handleSuccessfulAuth(AccountData account, const Server& server, std::string authToken, std::string serverIdent, int commentId, int64_t expiresIn, AuthMethod method, int target) {
+    std::optional<PendingCleanup> cleanup;
+
+    if (commentId != 0) {
+        cleanup = PendingCleanup {
+            .url = account.serverUrl,
+            .accountId = account.accountId,
+            .kind = method == AuthMethod::Comment ? CleanupKind::Comment : CleanupKind::Message,
+            .id = commentId,
+            .levelId = method == AuthMethod::Comment ? target : 0,
+        };
+    }
+
+    // save authtoken right away, anyone waiting for this auth to finish should find it in the storage
+    auto res = ArgonStorage::get().storeAuthToken(account, server.url(), serverIdent, authToken, this->computeExpiry(expiresIn), std::move(cleanup));
+    if (!res) {
+        log::warn("(Argon) failed to save authtoken: {}", res.unwrapErr());
+    }
+
+    if (commentId == 0) return;
+
+    CleanupQueue::get().drain(std::move(account), server);
 }
 
 }
@@ -1,36 +1,115 @@
 #pragma once
 #include <argon/argon.hpp>
 #include "util.hpp"
+#include "SharedTokenTable.hpp"
+#include "AuthFlight.hpp"
+#include "RequestScheduler.hpp"
 
 #include <asp/sync/Mutex.hpp>
 #include <asp/time/SystemTime.hpp>
 #include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace argon {
 
+// Settings that are read on every request. A snapshot is never modified once published, changing a setting publishes a new one.
+struct ConfigSnapshot {
+    // the server used when none is given explicitly
+    ServerConfig server;
+};
+
 class ArgonState : public SingletonBase<ArgonState> {
 public:
+    // Returns the current configuration without locking. The snapshot does not see later changes,
+    // and is freed once nobody holds on to it anymore.
+    std::shared_ptr<const ConfigSnapshot> config() const;
+
     void setServerUrl(std::string url);
     std::string getServerUrl() const;
-    std::string makeUrl(std::string_view suffix) const;
 
     void setCertVerification(bool state);
     bool getCertVerification() const;
 
+    void setBackgroundAuth(bool state);
+    bool getBackgroundAuth() const;
+
+    void setDefaultTokenLifetime(int64_t secs);
+    bool hasDefaultTokenLifetime() const;
+    // Returns the unix timestamp at which a token issued now expires, or 0 if unknown
+    int64_t computeExpiry(int64_t expiresIn) const;
+
+    // Margin in seconds, 0 means refreshing is disabled
+    void setRefreshMargin(int64_t secs);
+    int64_t getRefreshMargin() const;
+    // An account whose token is kept fresh, along with the server it was authenticated against
+    struct RefreshEntry {
+        AccountData account;
+        Server server;
+    };
+
+    // Adds the pair to the set, or replaces the entry with the same server URL, account ID and user ID
+    void addRefreshEntry(const AccountData& account, const Server& server);
+    void removeRefreshEntry(const AccountData& account, std::string_view serverUrl);
+    std::vector<RefreshEntry> getRefreshEntries() const;
+    // Returns true if the caller should start the refresh loop
+    bool tryStartRefresher();
+    void refresherStopped();
+
     std::lock_guard<std::mutex> acquireConfigLock();
     void initConfigLock();
     bool isConfigLockInitialized();
 
-    void handleSuccessfulAuth(AccountData account, std::string authToken, std::string serverIdent, int commentId);
+    // Token table shared across all copies of Argon, must only be accessed with the config lock held
+    SharedTokenTable& getTokenTable();
+    // Authentications in progress across all copies of Argon
+    SharedAuthFlights& getAuthFlights();
+    // Pacing of requests to GD servers across all copies of Argon
+    SharedRequestScheduler& getRequestScheduler();
+
+    // Counters exposed through `argon::getAuthStats`
+    struct Counters {
+        std::atomic<uint64_t> started{0};
+        std::atomic<uint64_t> succeeded{0};
+        std::atomic<uint64_t> failed{0};
+        std::atomic<uint64_t> cached{0};
+        std::atomic<uint64_t> joined{0};
+        std::atomic<uint64_t> argonRequests{0};
+        std::atomic<uint64_t> gdRequests{0};
+    };
+
+    Counters& counters();
+    AuthStats getStats() const;
+
+    // `method` is the method that was used, either Message or Comment, and `target` is the challenge target (account or level ID)
+    void handleSuccessfulAuth(AccountData account, const Server& server, std::string authToken, std::string serverIdent, int commentId, int64_t expiresIn, AuthMethod method, int target);
 
 protected:
     friend class SingletonBase;
 
-    asp::Mutex<std::string> m_serverUrl;
-    std::atomic<bool> m_certVerification{true};
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<std::shared_ptr<const ConfigSnapshot>> m_config;
+#else
+    // libc++ has no std::atomic<std::shared_ptr> yet, only accessed through std::atomic_load and std::atomic_store
+    std::shared_ptr<const ConfigSnapshot> m_config;
+#endif
+    // serializes writers, readers never take it
+    std::mutex m_configWriteMutex;
+    std::atomic<bool> m_backgroundAuth{false};
+    std::atomic<int64_t> m_defaultTokenLifetime{0};
+    std::atomic<int64_t> m_refreshMargin{0};
+    std::atomic<bool> m_refresherRunning{false};
+    asp::Mutex<std::vector<RefreshEntry>> m_refreshEntries;
     std::atomic<std::mutex*> m_configLock = nullptr;
+    std::atomic<SharedTokenTable*> m_tokenTable = nullptr;
+    std::atomic<SharedAuthFlights*> m_authFlights = nullptr;
+    std::atomic<SharedRequestScheduler*> m_requestScheduler = nullptr;
+    Counters m_counters;
 
     ArgonState();
+
+    template <typename F>
+    void updateConfig(F&& update);
 };
 
 }
\ No newline at end of file
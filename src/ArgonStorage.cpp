@@ -1,19 +1,40 @@
 #include "ArgonStorage.hpp"
 #include "ArgonState.hpp"
+#include "MappedFile.hpp"
 
+#include <argon/core/BinaryTokenStore.hpp>
 #include <Geode/loader/Dirs.hpp>
 #include <Geode/utils/file.hpp>
 #include <matjson.hpp>
 #include <asp/fs.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <span>
+
+#ifdef GEODE_IS_WINDOWS
+# include <io.h>
+#else
+# include <fcntl.h>
+# include <unistd.h>
+#endif
 
 using namespace geode::prelude;
 
 static auto storagePath = geode::dirs::getModsSaveDir() / ".dankmeme.argon-data.json";
+static auto backupPath = geode::dirs::getModsSaveDir() / ".dankmeme.argon-data.json.bak";
+static auto binaryPath = geode::dirs::getModsSaveDir() / ".dankmeme.argon-data.bin";
 
 namespace argon {
 
 ArgonStorage::ArgonStorage() {}
 
+int64_t unixTimestamp() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
 static matjson::Value makeNewConfigFile() {
     return matjson::makeObject({
         {"_ver", 0},
@@ -42,158 +63,587 @@ static Result<matjson::Value> parseConfigFile(const std::string& data) {
     return Ok(std::move(out));
 }
 
+static Result<matjson::Value> readConfigFile(const std::filesystem::path& path) {
+    GEODE_UNWRAP_INTO(auto data, geode::utils::file::readString(path));
+    return parseConfigFile(data);
+}
+
 static matjson::Value loadOrCreateConfig() {
-    matjson::Value data;
+    bool hasMainFile = asp::fs::isFile(storagePath);
 
-    if (asp::fs::isFile(storagePath)) {
-        auto res = geode::utils::file::readString(storagePath);
-        if (!res) {
-            log::warn("(Argon) failed to read argon data file: {}", res.unwrapErr());
-            data = makeNewConfigFile();
-        } else {
-            auto res2 = parseConfigFile(res.unwrap());
-            if (!res2) {
-                log::warn("(Argon) failed to read config file, resetting: {}", res2.unwrapErr());
-                data = makeNewConfigFile();
-            } else {
-                data = std::move(res2).unwrap();
-            }
+    if (hasMainFile) {
+        auto res = readConfigFile(storagePath);
+        if (res) {
+            return std::move(res).unwrap();
         }
-    } else {
-        data = makeNewConfigFile();
+
+        log::warn("(Argon) failed to read argon data file: {}", res.unwrapErr());
+    }
+
+    // main file is either missing or broken, which can happen if the game crashed in the middle of a write.
+    // in that case the last good copy is still there, and we would rather not make the user re-auth every account
+    if (asp::fs::isFile(backupPath)) {
+        auto res = readConfigFile(backupPath);
+        if (res) {
+            log::info("(Argon) restored argon data from backup file");
+            return std::move(res).unwrap();
+        }
+
+        log::warn("(Argon) failed to read argon data backup file: {}", res.unwrapErr());
     }
 
-    data["_ver"] = data["_ver"].asUInt().unwrapOr(0) + 1;
+    if (hasMainFile) {
+        log::warn("(Argon) resetting argon data file");
+    }
 
-    return data;
+    return makeNewConfigFile();
 }
 
-Result<> ArgonStorage::storeAuthToken(const AccountData& account, std::string_view serverIdent, std::string_view authtoken) {
-    auto _lock = ArgonState::get().acquireConfigLock();
+// Writes the data and flushes it all the way to the disk before returning. Without an offset the file is replaced,
+// otherwise it must already exist and only the bytes at that offset are overwritten.
+static Result<> writeFileSynced(const std::filesystem::path& path, std::span<const uint8_t> data, std::optional<size_t> offset = std::nullopt) {
+#ifdef GEODE_IS_WINDOWS
+    std::FILE* file = _wfopen(path.c_str(), offset ? L"r+b" : L"wb");
+#else
+    std::FILE* file = std::fopen(path.c_str(), offset ? "r+b" : "wb");
+#endif
+
+    if (!file) {
+        return Err("failed to open {}: {}", path.filename().string(), std::strerror(errno));
+    }
+
+    bool ok = (!offset || std::fseek(file, *offset, SEEK_SET) == 0)
+        && std::fwrite(data.data(), 1, data.size(), file) == data.size()
+        && std::fflush(file) == 0;
+
+#ifdef GEODE_IS_WINDOWS
+    ok = ok && _commit(_fileno(file)) == 0;
+#else
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+
+    int err = errno;
+    ok = std::fclose(file) == 0 && ok;
 
-    auto data = loadOrCreateConfig();
+    if (!ok) {
+        return Err("failed to write {}: {}", path.filename().string(), std::strerror(err));
+    }
+
+    return Ok();
+}
 
-    // find if theres any token that has the same data, replace it instead of adding a new entry
-    bool insertedToken = false;
+static Result<> writeFileSynced(const std::filesystem::path& path, std::string_view data) {
+    return writeFileSynced(path, std::span{reinterpret_cast<const uint8_t*>(data.data()), data.size()});
+}
 
+// Makes a rename in this directory durable, no-op on windows where there is no portable way to do this
+static void syncDirectory(const std::filesystem::path& dir) {
+#ifndef GEODE_IS_WINDOWS
+    int fd = open(dir.c_str(), O_RDONLY);
+    if (fd != -1) {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+}
+
+// FNV-1a, only used to tell whether token metadata belongs to the token next to it
+static uint32_t tokenFingerprint(std::string_view token) {
+    uint32_t hash = 2166136261u;
+
+    for (char c : token) {
+        hash ^= (uint8_t) c;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static std::vector<StoredToken> tokensFromJson(const matjson::Value& data) {
     // parseConfigFile already verified for us that data["tokens"] will be valid
     auto& arr = data["tokens"].asArray().unwrap();
 
-    auto serverUrl = ArgonState::get().getServerUrl();
+    std::vector<StoredToken> out;
+    out.reserve(arr.size());
 
     for (auto& value : arr) {
-        std::string url = value["url"].asString().unwrapOrDefault();
-        int accountId = value["accid"].asInt().unwrapOrDefault();
-        int userId = value["userid"].asInt().unwrapOrDefault();
-
-        if (url != serverUrl
-            || accountId != account.accountId
-            || userId != account.userId
-        ) {
-            continue;
+        auto& token = out.emplace_back(StoredToken {
+            .url = value["url"].asString().unwrapOrDefault(),
+            .accountId = value["accid"].asInt().unwrapOrDefault(),
+            .userId = value["userid"].asInt().unwrapOrDefault(),
+            .username = value["name"].asString().unwrapOrDefault(),
+            .ident = value["ident"].asString().unwrapOrDefault(),
+            .token = value["token"].asString().unwrapOrDefault(),
+        });
+
+        // older versions of argon keep these fields around when they replace the token,
+        // so they are only trusted if they were written for this exact token
+        if (value["meta"].asUInt().unwrapOrDefault() == tokenFingerprint(token.token)) {
+            token.issuedAt = value["issued"].asInt().unwrapOrDefault();
+            token.expiresAt = value["expires"].asInt().unwrapOrDefault();
+            token.validatedAt = value["validated"].asInt().unwrapOrDefault();
         }
+    }
 
-        // if the same url and account ID, this leaves ident, username and the token fields to be arbitrary
-        // and indeed, we will ignore their current values and just replace them
-        value["name"] = account.username;
-        value["ident"] = serverIdent;
-        value["token"] = authtoken;
+    return out;
+}
+
+static matjson::Value tokensToJson(const std::vector<StoredToken>& tokens) {
+    std::vector<matjson::Value> arr;
+    arr.reserve(tokens.size());
 
-        insertedToken = true;
-        break;
+    for (auto& token : tokens) {
+        arr.push_back(matjson::makeObject({
+            {"url", token.url},
+            {"accid", token.accountId},
+            {"userid", token.userId},
+            {"name", token.username},
+            {"ident", token.ident},
+            {"token", token.token},
+            {"issued", token.issuedAt},
+            {"expires", token.expiresAt},
+            {"validated", token.validatedAt},
+            {"meta", tokenFingerprint(token.token)},
+        }));
+    }
+
+    return matjson::Value(std::move(arr));
+}
+
+// older versions of argon don't know about this field and drop it when they write the file,
+// which only means that those messages won't be cleaned up
+static std::vector<PendingCleanup> cleanupsFromJson(const matjson::Value& data) {
+    std::vector<PendingCleanup> out;
+
+    auto arr = data["cleanup"].asArray();
+    if (!arr) {
+        return out;
     }
 
-    if (!insertedToken) {
+    out.reserve(arr.unwrap().size());
+
+    for (auto& value : arr.unwrap()) {
+        out.push_back(PendingCleanup {
+            .url = value["url"].asString().unwrapOrDefault(),
+            .accountId = value["accid"].asInt().unwrapOrDefault(),
+            .kind = value["comment"].asBool().unwrapOr(false) ? CleanupKind::Comment : CleanupKind::Message,
+            .id = value["id"].asInt().unwrapOrDefault(),
+            .levelId = value["level"].asInt().unwrapOrDefault(),
+            .attempts = (uint32_t) value["attempts"].asUInt().unwrapOrDefault(),
+            .notBefore = value["after"].asInt().unwrapOrDefault(),
+        });
+    }
+
+    return out;
+}
+
+static matjson::Value cleanupsToJson(const std::vector<PendingCleanup>& cleanups) {
+    std::vector<matjson::Value> arr;
+    arr.reserve(cleanups.size());
+
+    for (auto& cleanup : cleanups) {
         arr.push_back(matjson::makeObject({
-            {"url", serverUrl},
-            {"accid", account.accountId},
-            {"userid", account.userId},
-            {"name", account.username},
-            {"ident", serverIdent},
-            {"token", authtoken},
+            {"url", cleanup.url},
+            {"accid", cleanup.accountId},
+            {"comment", cleanup.kind == CleanupKind::Comment},
+            {"id", cleanup.id},
+            {"level", cleanup.levelId},
+            {"attempts", cleanup.attempts},
+            {"after", cleanup.notBefore},
         }));
     }
 
-    auto res = geode::utils::file::writeToJson(storagePath, data);
+    return matjson::Value(std::move(arr));
+}
+
+// Loads the binary data file, if it exists and is up to date with the JSON file.
+// The file is decoded in full and unmapped right after, the table never points into it.
+static std::optional<core::BinaryStoreContents> loadBinaryStore(const FileStamp& jsonStamp) {
+    if (!jsonStamp.exists || !asp::fs::isFile(binaryPath)) {
+        return std::nullopt;
+    }
+
+    auto file = MappedFile::open(binaryPath);
+    if (!file) {
+        log::warn("(Argon) failed to open binary argon data file: {}", file.unwrapErr());
+        return std::nullopt;
+    }
+
+    auto res = core::decodeBinaryStore(file.unwrap().data());
     if (!res) {
-        return Err(fmt::format("failed to save argon data file: {}", res.unwrapErr()));
+        log::warn("(Argon) failed to read binary argon data file: {}", res.error());
+        return std::nullopt;
     }
 
-    return Ok();
+    auto contents = std::move(*res);
+
+    // JSON file was written after this one, most likely by an older version of argon
+    if (!core::binaryStoreMatches(contents, jsonStamp)) {
+        log::debug("(Argon) binary argon data file is outdated, reading the JSON file");
+        return std::nullopt;
+    }
+
+    return contents;
 }
 
-std::optional<std::string> ArgonStorage::getAuthToken(const AccountData& account, std::string_view serverUrl) {
+TokenTable ArgonStorage::syncTable() {
+    // the table is shared with other copies of argon, so whoever loaded or wrote it last already did the work for us.
+    // the file only needs to be read again if it was modified by someone that doesn't know about the shared table.
+    TokenTable table{ArgonState::get().getTokenTable()};
+
+    auto stamp = FileStamp::of(storagePath);
+    if (table->loaded && toSharedStamp(stamp) == table->stamp) {
+        return table;
+    }
+
+    if (auto contents = loadBinaryStore(stamp)) {
+        table.assignTokens(contents->tokens);
+        table.assignCleanups(contents->cleanups);
+        table->generation = contents->generation;
+    } else {
+        auto data = loadOrCreateConfig();
+
+        table.assignTokens(tokensFromJson(data));
+        table.assignCleanups(cleanupsFromJson(data));
+        table->generation = data["_ver"].asUInt().unwrapOr(0);
+    }
+
+    table->writtenGeneration = table->generation;
+    table->stamp = toSharedStamp(stamp);
+    table->loaded = true;
+
+    return table;
+}
+
+ArgonStorage::PendingWrite ArgonStorage::prepareWrite(TokenTable table) {
+    table->generation++;
+
+    return PendingWrite {
+        .generation = table->generation,
+        .tokens = table.tokens(),
+        .cleanups = table.cleanups(),
+        .binary = table->binaryStorage != 0,
+    };
+}
+
+Result<> ArgonStorage::commitWrite(PendingWrite write) {
+    // serializing and writing happens without the config lock, it is only taken again to swap the files
+    auto data = matjson::makeObject({
+        {"_ver", write.generation},
+        {"tokens", tokensToJson(write.tokens)},
+        {"cleanup", cleanupsToJson(write.cleanups)},
+    });
+
+    auto tmpPath = storagePath;
+    tmpPath += fmt::format(".{}.tmp", write.generation);
+
+    auto res = writeFileSynced(tmpPath, data.dump());
+
+    auto binTmpPath = binaryPath;
+    binTmpPath += fmt::format(".{}.tmp", write.generation);
+
+    Result<> binRes = Ok();
+    if (write.binary) {
+        binRes = writeFileSynced(binTmpPath, core::encodeBinaryStore(write.generation, write.tokens, write.cleanups));
+    }
+
     auto _lock = ArgonState::get().acquireConfigLock();
+    TokenTable table{ArgonState::get().getTokenTable()};
 
-    auto data = loadOrCreateConfig();
+    std::error_code ec;
 
-    // parseConfigFile already verified for us that data["tokens"] will be valid
-    auto& arr = data["tokens"].asArray().unwrap();
+    // someone else has written a newer snapshot while we were busy, which already includes our changes
+    if (write.generation <= table->writtenGeneration) {
+        std::filesystem::remove(tmpPath, ec);
+        std::filesystem::remove(binTmpPath, ec);
+        return Ok();
+    }
 
-    for (auto& value : arr) {
-        int accountId = value["accid"].asInt().unwrapOrDefault();
-        int userId = value["userid"].asInt().unwrapOrDefault();
+    if (!res) {
+        std::filesystem::remove(tmpPath, ec);
+        std::filesystem::remove(binTmpPath, ec);
 
-        if (accountId != account.accountId || userId != account.userId) {
-            continue;
+        // don't trust the in-memory state anymore, reload it from disk next time
+        table->loaded = false;
+        return Err(fmt::format("failed to save argon data file: {}", res.unwrapErr()));
+    }
+
+    // keep the current file as the last good copy, if we crash between the two renames it will be restored on next load
+    if (asp::fs::isFile(storagePath)) {
+        std::filesystem::rename(storagePath, backupPath, ec);
+        if (ec) {
+            log::warn("(Argon) failed to back up argon data file: {}", ec.message());
         }
+    }
 
-        std::string url = value["url"].asString().unwrapOrDefault();
+    std::filesystem::rename(tmpPath, storagePath, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        std::filesystem::remove(binTmpPath, ec);
 
-        if (url != serverUrl) {
-            continue;
+        table->loaded = false;
+        return Err(fmt::format("failed to save argon data file: {}", ec.message()));
+    }
+
+    auto stamp = FileStamp::of(storagePath);
+    table->writtenGeneration = write.generation;
+    table->stamp = toSharedStamp(stamp);
+
+    // JSON file is the source of truth, failing to update the binary one only makes the next load slower
+    if (write.binary) {
+        if (binRes) {
+            // binary file is only valid for this exact version of the JSON file
+            binRes = writeFileSynced(binTmpPath, core::encodeBinaryStoreStamp(stamp), core::BINARY_STORE_STAMP_OFFSET);
         }
 
-        std::string username = value["name"].asString().unwrapOrDefault();
+        if (binRes) {
+            std::filesystem::rename(binTmpPath, binaryPath, ec);
+            if (ec) {
+                binRes = Err(ec.message());
+            }
+        }
 
-        if (username != account.username) {
-            continue;
+        if (!binRes) {
+            std::filesystem::remove(binTmpPath, ec);
+            log::warn("(Argon) failed to save binary argon data file: {}", binRes.unwrapErr());
+        }
+    }
+
+    syncDirectory(storagePath.parent_path());
+
+    return Ok();
+}
+
+Result<> ArgonStorage::storeAuthToken(const AccountData& account, std::string_view serverUrl, std::string_view serverIdent, std::string_view authtoken, int64_t expiresAt, std::optional<PendingCleanup> cleanup) {
+    PendingWrite write;
+
+    {
+        auto _lock = ArgonState::get().acquireConfigLock();
+
+        auto table = this->syncTable();
+
+        // if there's a token with the same url and account ID, it gets replaced,
+        // its ident, username and token fields are arbitrary and we just overwrite them
+        table.upsert(StoredToken {
+            .url = std::string{serverUrl},
+            .accountId = account.accountId,
+            .userId = account.userId,
+            .username = account.username,
+            .ident = std::string{serverIdent},
+            .token = std::string{authtoken},
+            .issuedAt = unixTimestamp(),
+            .expiresAt = expiresAt,
+        });
+
+        // saved in the same write, so that the message is never forgotten about even if the game is closed right after
+        if (cleanup) {
+            auto cleanups = table.cleanups();
+            cleanups.push_back(std::move(*cleanup));
+            table.assignCleanups(cleanups);
+        }
+
+        write = this->prepareWrite(table);
+    }
+
+    return this->commitWrite(std::move(write));
+}
+
+std::optional<StoredToken> ArgonStorage::getTokenRecord(const AccountData& account, std::string_view serverUrl) {
+    auto _lock = ArgonState::get().acquireConfigLock();
+
+    auto token = this->syncTable().find(serverUrl, account.accountId, account.userId);
+
+    if (!token || token->username != account.username) {
+        return std::nullopt;
+    }
+
+    return token;
+}
+
+std::optional<std::string> ArgonStorage::getAuthToken(const AccountData& account, std::string_view serverUrl) {
+    auto record = this->getTokenRecord(account, serverUrl);
+    if (!record) {
+        return std::nullopt;
+    }
+
+    return std::move(record->token);
+}
+
+void ArgonStorage::markValidated(const AccountData& account, std::string_view serverUrl) {
+    PendingWrite write;
+
+    {
+        auto _lock = ArgonState::get().acquireConfigLock();
+
+        auto table = this->syncTable();
+
+        auto token = table.find(serverUrl, account.accountId, account.userId);
+        if (!token || token->username != account.username) {
+            return;
         }
 
-        // std::string ident = value["ident"].asString().unwrapOrDefault();
-        std::string token = value["token"].asString().unwrapOrDefault();
+        token->validatedAt = unixTimestamp();
+        table.upsert(*token);
 
-        return std::make_optional(std::move(token));
+        write = this->prepareWrite(table);
     }
 
-    return std::nullopt;
+    if (auto err = this->commitWrite(std::move(write)).err()) {
+        log::warn("(Argon) {}", *err);
+    }
 }
 
 bool ArgonStorage::hasAuthToken(const AccountData& account, std::string_view serverUrl) {
     return this->getAuthToken(account, serverUrl).has_value();
 }
 
-void ArgonStorage::clearTokens(int accountId) {
-    auto _lock = ArgonState::get().acquireConfigLock();
+void ArgonStorage::clearTokens(int accountId, std::string_view serverUrl) {
+    PendingWrite write;
 
-    auto data = loadOrCreateConfig();
+    {
+        auto _lock = ArgonState::get().acquireConfigLock();
 
-    // parseConfigFile already verified for us that data["tokens"] will be valid
-    auto& arr = data["tokens"].asArray().unwrap();
+        auto table = this->syncTable();
+        if (table.eraseAccount(accountId, serverUrl) == 0) {
+            return;
+        }
+
+        write = this->prepareWrite(table);
+    }
 
-    for (int i = arr.size() - 1; i >= 0; i--) {
-        auto& val = arr[i];
+    if (auto err = this->commitWrite(std::move(write)).err()) {
+        log::warn("(Argon) {}", *err);
+    }
+}
 
-        if (val["accid"].asInt().unwrapOrDefault() == accountId) {
-            arr.erase(arr.begin() + i);
+void ArgonStorage::clearAllTokens(std::string_view serverUrl) {
+    PendingWrite write;
+
+    {
+        auto _lock = ArgonState::get().acquireConfigLock();
+
+        auto table = this->syncTable();
+        if (table.eraseServer(serverUrl) == 0) {
+            return;
         }
+
+        write = this->prepareWrite(table);
     }
 
-    auto res = geode::utils::file::writeToJson(storagePath, data);
-    if (!res) {
-        log::warn("(Argon) failed to save argon data file: {}", res.unwrapErr());
+    if (auto err = this->commitWrite(std::move(write)).err()) {
+        log::warn("(Argon) {}", *err);
     }
 }
 
-void ArgonStorage::clearAllTokens() {
+std::vector<PendingCleanup> ArgonStorage::claimDueCleanups(int accountId, std::string_view url, int64_t leaseSecs) {
     auto _lock = ArgonState::get().acquireConfigLock();
 
-    auto data = loadOrCreateConfig();
-    data["tokens"] = matjson::Value::array();
+    auto table = this->syncTable();
+    auto cleanups = table.cleanups();
+    auto now = unixTimestamp();
 
-    auto res = geode::utils::file::writeToJson(storagePath, data);
-    if (!res) {
-        log::warn("(Argon) failed to save argon data file: {}", res.unwrapErr());
+    std::vector<PendingCleanup> out;
+
+    for (auto& cleanup : cleanups) {
+        if (cleanup.accountId != accountId || cleanup.url != url || cleanup.notBefore > now) {
+            continue;
+        }
+
+        out.push_back(cleanup);
+
+        // only pushed back in memory, anyone else reading the table (other mods) won't pick it up while we're on it.
+        // if it doesn't get written before the game closes, it's just due again on next launch.
+        cleanup.notBefore = now + leaseSecs;
+    }
+
+    if (!out.empty()) {
+        table.assignCleanups(cleanups);
+    }
+
+    return out;
+}
+
+void ArgonStorage::finishCleanups(const std::vector<PendingCleanup>& done, const std::vector<PendingCleanup>& failed, uint32_t maxAttempts) {
+    if (done.empty() && failed.empty()) {
+        return;
+    }
+
+    PendingWrite write;
+
+    {
+        auto _lock = ArgonState::get().acquireConfigLock();
+
+        auto table = this->syncTable();
+        auto cleanups = table.cleanups();
+        auto now = unixTimestamp();
+
+        auto matches = [](const std::vector<PendingCleanup>& list, const PendingCleanup& cleanup) {
+            return std::any_of(list.begin(), list.end(), [&](auto& other) { return other.sameAs(cleanup); });
+        };
+
+        std::erase_if(cleanups, [&](PendingCleanup& cleanup) {
+            if (matches(done, cleanup)) {
+                return true;
+            }
+
+            if (matches(failed, cleanup)) {
+                cleanup.attempts++;
+
+                // 30 seconds, doubling every attempt, up to a day
+                cleanup.notBefore = now + std::min<int64_t>(30ll << std::min<uint32_t>(cleanup.attempts, 12), 86400);
+
+                return cleanup.attempts >= maxAttempts;
+            }
+
+            return false;
+        });
+
+        table.assignCleanups(cleanups);
+        write = this->prepareWrite(table);
+    }
+
+    if (auto err = this->commitWrite(std::move(write)).err()) {
+        log::warn("(Argon) {}", *err);
+    }
+}
+
+std::optional<int64_t> ArgonStorage::nextCleanupTime(int accountId, std::string_view url) {
+    auto _lock = ArgonState::get().acquireConfigLock();
+
+    std::optional<int64_t> out;
+
+    for (auto& cleanup : this->syncTable().cleanups()) {
+        if (cleanup.accountId == accountId && cleanup.url == url) {
+            out = std::min(out.value_or(cleanup.notBefore), cleanup.notBefore);
+        }
+    }
+
+    return out;
+}
+
+void ArgonStorage::setBinaryStorage(bool state) {
+    PendingWrite write;
+
+    {
+        auto _lock = ArgonState::get().acquireConfigLock();
+
+        auto table = this->syncTable();
+        if ((table->binaryStorage != 0) == state) {
+            return;
+        }
+
+        table->binaryStorage = state;
+
+        if (!state) {
+            return;
+        }
+
+        // write the binary file right away, so the next load can already use it
+        write = this->prepareWrite(table);
+    }
+
+    if (auto err = this->commitWrite(std::move(write)).err()) {
+        log::warn("(Argon) {}", *err);
     }
 }
 
@@ -1,22 +1,63 @@
 #pragma once
 #include "util.hpp"
+#include "SharedTokenTable.hpp"
 #include <argon/argon.hpp>
 
 namespace argon {
 
+// Current time as a unix timestamp in seconds
+int64_t unixTimestamp();
+
 class ArgonStorage : public SingletonBase<ArgonStorage> {
     friend class SingletonBase;
     ArgonStorage();
 
 public:
-    geode::Result<> storeAuthToken(const AccountData& account, std::string_view serverIdent, std::string_view authtoken);
+    // `expiresAt` is a unix timestamp, or 0 if the token has no known expiry.
+    // If `cleanup` is given, it is added to the cleanup queue in the same write.
+    geode::Result<> storeAuthToken(
+        const AccountData& account,
+        std::string_view serverUrl,
+        std::string_view serverIdent,
+        std::string_view authtoken,
+        int64_t expiresAt = 0,
+        std::optional<PendingCleanup> cleanup = std::nullopt
+    );
+    std::optional<StoredToken> getTokenRecord(const AccountData& account, std::string_view serverUrl);
     std::optional<std::string> getAuthToken(const AccountData& account, std::string_view serverUrl);
     bool hasAuthToken(const AccountData& account, std::string_view serverUrl);
 
-    void clearTokens(int accountId);
-    void clearAllTokens();
+    // Records that the token was just accepted by someone
+    void markValidated(const AccountData& account, std::string_view serverUrl);
+
+    // Both only remove tokens of the given server
+    void clearTokens(int accountId, std::string_view serverUrl);
+    void clearAllTokens(std::string_view serverUrl);
+
+    // Returns the cleanups of this account that are due, and delays them by `leaseSecs` so nobody else attempts them meanwhile
+    std::vector<PendingCleanup> claimDueCleanups(int accountId, std::string_view url, int64_t leaseSecs);
+    // Removes the successful cleanups, and delays the failed ones with backoff, dropping those that failed too many times
+    void finishCleanups(const std::vector<PendingCleanup>& done, const std::vector<PendingCleanup>& failed, uint32_t maxAttempts);
+    // Returns when the next cleanup of this account is due, if there are any
+    std::optional<int64_t> nextCleanupTime(int accountId, std::string_view url);
+
+    void setBinaryStorage(bool state);
 
 private:
+    // Snapshot of the table that is about to be written to disk
+    struct PendingWrite {
+        uint64_t generation = 0;
+        std::vector<StoredToken> tokens;
+        std::vector<PendingCleanup> cleanups;
+        bool binary = false;
+    };
+
+    // Both of these must be called with the config lock held
+    TokenTable syncTable();
+    PendingWrite prepareWrite(TokenTable table);
+
+    // Must be called without the config lock held, it is only acquired for the final rename
+    geode::Result<> commitWrite(PendingWrite write);
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,196 @@
+#include "AuthFlight.hpp"
+#include "ArgonState.hpp"
+
+#include <arc/sync/Notify.hpp>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace argon {
+
+namespace {
+
+// What the opaque flight pointers point to, only ever touched by the copy that created the flights
+struct FlightImpl {
+    std::string key;
+    // one for the map entry while in progress, one for every handle
+    size_t refs = 0;
+    bool finished = false;
+    FlightOutcome outcome = FlightOutcome::Abandoned;
+    std::string result;
+    std::vector<SharedFlightWaiter> waiters;
+};
+
+struct FlightsImpl {
+    std::mutex mutex;
+    std::unordered_map<std::string, FlightImpl*> flights;
+};
+
+}
+
+static FlightsImpl& implOf(SharedAuthFlights* shared) {
+    return *static_cast<FlightsImpl*>(shared->impl);
+}
+
+// Must be called with the mutex held
+static void unref(FlightImpl* flight) {
+    if (--flight->refs == 0) {
+        delete flight;
+    }
+}
+
+static constexpr SharedAuthFlightsFns FLIGHTS_FNS = {
+    .join = [](SharedAuthFlights* shared, SharedStr key, uint8_t* leader) -> void* {
+        auto& impl = implOf(shared);
+        std::lock_guard lock(impl.mutex);
+
+        auto& flight = impl.flights[std::string{key.data, key.size}];
+        *leader = !flight;
+
+        if (!flight) {
+            flight = new FlightImpl{ .key = std::string{key.data, key.size}, .refs = 1 };
+        }
+
+        flight->refs++;
+        return flight;
+    },
+
+    .subscribe = [](SharedAuthFlights* shared, void* ptr, SharedFlightWaiter waiter) {
+        auto& impl = implOf(shared);
+        std::lock_guard lock(impl.mutex);
+
+        auto flight = static_cast<FlightImpl*>(ptr);
+        if (flight->finished) {
+            return false;
+        }
+
+        flight->waiters.push_back(waiter);
+        return true;
+    },
+
+    .complete = [](SharedAuthFlights* shared, void* ptr, uint8_t outcome, SharedStr result) {
+        auto& impl = implOf(shared);
+        auto flight = static_cast<FlightImpl*>(ptr);
+
+        std::vector<SharedFlightWaiter> waiters;
+
+        {
+            std::lock_guard lock(impl.mutex);
+
+            flight->finished = true;
+            flight->outcome = (FlightOutcome) outcome;
+            flight->result = std::string{result.data, result.size};
+            waiters = std::move(flight->waiters);
+
+            auto it = impl.flights.find(flight->key);
+            if (it != impl.flights.end() && it->second == flight) {
+                impl.flights.erase(it);
+                unref(flight);
+            }
+        }
+
+        // the caller still holds its own reference, so the flight outlives this
+        for (auto& waiter : waiters) {
+            waiter.wake(waiter.ctx);
+        }
+    },
+
+    .result = [](SharedAuthFlights* shared, void* ptr, SharedStr* out) {
+        auto& impl = implOf(shared);
+        std::lock_guard lock(impl.mutex);
+
+        auto flight = static_cast<FlightImpl*>(ptr);
+        *out = SharedStr{flight->result.data(), flight->result.size()};
+        return (uint8_t) flight->outcome;
+    },
+
+    .release = [](SharedAuthFlights* shared, void* ptr) {
+        auto& impl = implOf(shared);
+        std::lock_guard lock(impl.mutex);
+
+        unref(static_cast<FlightImpl*>(ptr));
+    },
+};
+
+SharedAuthFlights::SharedAuthFlights() : fns(&FLIGHTS_FNS), impl(new FlightsImpl{}) {}
+
+AuthFlightHandle AuthFlightHandle::join(std::string_view serverUrl, const AuthOptions& options) {
+    auto& shared = ArgonState::get().getAuthFlights();
+
+    auto key = fmt::format(
+        "{}|{}|{}|{}|{}",
+        serverUrl, options.account.accountId, options.account.userId, options.forceStrong, (int) options.method
+    );
+
+    uint8_t leader = 0;
+
+    AuthFlightHandle handle;
+    handle.m_shared = &shared;
+    handle.m_flight = shared.fns->join(&shared, SharedStr{key.data(), key.size()}, &leader);
+    handle.m_leader = leader != 0;
+
+    return handle;
+}
+
+AuthFlightHandle::AuthFlightHandle(AuthFlightHandle&& other)
+    : m_shared(std::exchange(other.m_shared, nullptr)),
+      m_flight(std::exchange(other.m_flight, nullptr)),
+      m_leader(other.m_leader),
+      m_finished(other.m_finished) {}
+
+AuthFlightHandle::~AuthFlightHandle() {
+    if (!m_flight) return;
+
+    if (m_leader && !m_finished) {
+        std::string_view reason = "Authentication was cancelled";
+        m_shared->fns->complete(m_shared, m_flight, (uint8_t) FlightOutcome::Abandoned, SharedStr{reason.data(), reason.size()});
+    }
+
+    m_shared->fns->release(m_shared, m_flight);
+}
+
+bool AuthFlightHandle::isLeader() const {
+    return m_leader;
+}
+
+void AuthFlightHandle::finish(const geode::Result<std::string>& result) {
+    auto outcome = result.isOk() ? FlightOutcome::Success : FlightOutcome::Error;
+    auto& message = result.isOk() ? result.unwrap() : result.unwrapErr();
+
+    m_finished = true;
+    m_shared->fns->complete(m_shared, m_flight, (uint8_t) outcome, SharedStr{message.data(), message.size()});
+}
+
+arc::Future<std::optional<geode::Result<std::string>>> AuthFlightHandle::wait() {
+    // the leader may live in a different copy of argon, so it wakes us through a plain callback.
+    // the callback owns a reference to the notify, in case this future is dropped before the flight finishes
+    auto notify = std::make_shared<arc::Notify>();
+
+    auto waiter = SharedFlightWaiter {
+        .ctx = new std::shared_ptr<arc::Notify>(notify),
+        .wake = [](void* ctx) {
+            auto notify = static_cast<std::shared_ptr<arc::Notify>*>(ctx);
+            (*notify)->notifyOne();
+            delete notify;
+        },
+    };
+
+    if (m_shared->fns->subscribe(m_shared, m_flight, waiter)) {
+        // a notification sent before we get here is kept, so it can't be missed
+        co_await notify->notified();
+    } else {
+        delete static_cast<std::shared_ptr<arc::Notify>*>(waiter.ctx);
+    }
+
+    SharedStr result;
+    auto outcome = (FlightOutcome) m_shared->fns->result(m_shared, m_flight, &result);
+
+    switch (outcome) {
+        case FlightOutcome::Success: co_return geode::Ok(std::string{result.data, result.size});
+        case FlightOutcome::Error: co_return geode::Err(std::string{result.data, result.size});
+        default: co_return std::nullopt;
+    }
+}
+
+}
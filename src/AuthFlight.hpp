@@ -0,0 +1,93 @@
+#pragma once
+#include "SharedTokenTable.hpp"
+#include <Geode/Result.hpp>
+#include <argon/argon.hpp>
+#include <optional>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace argon {
+
+enum class FlightOutcome : uint8_t {
+    Success = 0,
+    Error = 1,
+    // The leader was cancelled before finishing
+    Abandoned = 2,
+};
+
+// Called once when the flight finishes, from whichever thread finished it
+struct SharedFlightWaiter {
+    void* ctx;
+    void (*wake)(void* ctx);
+};
+
+struct SharedAuthFlights;
+
+// Implemented by the copy of Argon that created the flights, flights are opaque pointers to everyone else.
+// All of these are thread-safe.
+struct SharedAuthFlightsFns {
+    // Joins the flight with this key, or starts it if there is none, in which case `*leader` is set to 1.
+    // The returned flight must be released.
+    void* (*join)(SharedAuthFlights* shared, SharedStr key, uint8_t* leader);
+    // Returns false if the flight has already finished, otherwise the waiter is woken once it does
+    bool (*subscribe)(SharedAuthFlights* shared, void* flight, SharedFlightWaiter waiter);
+    // Leader only, stores the result, removes the flight so that anyone coming after starts a fresh one and wakes all waiters
+    void (*complete)(SharedAuthFlights* shared, void* flight, uint8_t outcome, SharedStr result);
+    // Only valid once the flight has finished, `out` stays valid until the flight is released
+    uint8_t (*result)(SharedAuthFlights* shared, void* flight, SharedStr* out);
+    void (*release)(SharedAuthFlights* shared, void* flight);
+};
+
+// Authentications currently in progress, keyed by (url, account ID, user ID, forceStrong, method).
+// Shared between every copy of Argon loaded into the game, same rules apply as for `SharedTokenTable`,
+// except that it's protected by its own mutex inside `impl`.
+struct SharedAuthFlights {
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t version = VERSION;
+    uint32_t size = sizeof(SharedAuthFlights);
+    const SharedAuthFlightsFns* fns;
+    void* impl;
+
+    // Only ever runs in the copy that creates the flights, the storage behind `impl` is never freed
+    SharedAuthFlights();
+};
+
+static_assert(SharedAuthFlights::VERSION == 1 && std::is_standard_layout_v<SharedAuthFlights>);
+#if SIZE_MAX == UINT64_MAX
+static_assert(sizeof(SharedFlightWaiter) == 16);
+static_assert(sizeof(SharedAuthFlightsFns) == 5 * sizeof(void*));
+static_assert(sizeof(SharedAuthFlights) == 24);
+#endif
+
+// Handle to a flight, either as the leader who does the actual work or as a follower waiting for its result.
+// If the leader is destroyed without finishing the flight (e.g. its future was cancelled), the flight is abandoned
+// and followers will try to take over.
+class AuthFlightHandle {
+public:
+    // Only callers with the same options share a flight, a token requested with other options would not be what they asked for
+    static AuthFlightHandle join(std::string_view serverUrl, const AuthOptions& options);
+
+    AuthFlightHandle(AuthFlightHandle&& other);
+    AuthFlightHandle& operator=(AuthFlightHandle&&) = delete;
+    ~AuthFlightHandle();
+
+    bool isLeader() const;
+
+    // Leader only, publishes the result to all followers
+    void finish(const geode::Result<std::string>& result);
+
+    // Follower only, waits for the leader to finish. Returns nullopt if the flight was abandoned.
+    arc::Future<std::optional<geode::Result<std::string>>> wait();
+
+private:
+    SharedAuthFlights* m_shared = nullptr;
+    void* m_flight = nullptr;
+    bool m_leader = false;
+    bool m_finished = false;
+
+    AuthFlightHandle() = default;
+};
+
+}
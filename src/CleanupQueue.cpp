@@ -0,0 +1,91 @@
+#include "CleanupQueue.hpp"
+#include "ArgonStorage.hpp"
+#include "Web.hpp"
+
+#include <arc/time/Sleep.hpp>
+#include <asp/time/Duration.hpp>
+#include <asp/time/Instant.hpp>
+
+using namespace geode::prelude;
+
+namespace argon {
+
+// how long a claimed cleanup is hidden from others, longer than any of the requests can take
+static constexpr int64_t CLAIM_LEASE_SECS = 120;
+static constexpr uint32_t MAX_ATTEMPTS = 8;
+static constexpr size_t MAX_BATCH = 25;
+// don't keep the loop sleeping for longer than this, whatever is left will be picked up by the next auth or launch
+static constexpr int64_t MAX_SLEEP_SECS = 600;
+
+void CleanupQueue::drain(AccountData account, Server server) {
+    if (!m_draining.lock()->insert(account.accountId).second) {
+        return;
+    }
+
+    arc::spawn([this, account = std::move(account), server = std::move(server)](this auto self) -> arc::Future<> {
+        co_await this->drainLoop(account, server);
+        m_draining.lock()->erase(account.accountId);
+    });
+}
+
+arc::Future<> CleanupQueue::drainLoop(AccountData account, Server server) {
+    auto& storage = ArgonStorage::get();
+
+    while (true) {
+        auto due = storage.claimDueCleanups(account.accountId, account.serverUrl, CLAIM_LEASE_SECS);
+
+        std::vector<PendingCleanup> done, failed;
+        std::vector<PendingCleanup> batch;
+
+        auto finish = [&](const PendingCleanup& cleanup, bool ok) {
+            (ok ? done : failed).push_back(cleanup);
+        };
+
+        for (auto& cleanup : due) {
+            // messages that failed before are deleted one by one, in case it was the bulk deletion that isn't supported
+            if (cleanup.kind == CleanupKind::Message && cleanup.attempts == 0) {
+                batch.push_back(cleanup);
+                continue;
+            }
+
+            Result<> res = Ok();
+            if (cleanup.kind == CleanupKind::Comment) {
+                res = co_await web::deleteGDComment(server, account, cleanup.levelId, cleanup.id);
+            } else {
+                res = co_await web::deleteGDMessage(server, account, cleanup.id);
+            }
+
+            finish(cleanup, res.isOk());
+        }
+
+        for (size_t start = 0; start < batch.size(); start += MAX_BATCH) {
+            size_t end = std::min(start + MAX_BATCH, batch.size());
+
+            std::vector<int> ids;
+            for (size_t i = start; i < end; i++) {
+                ids.push_back(batch[i].id);
+            }
+
+            auto res = co_await web::deleteGDMessages(server, account, ids);
+            if (!res) {
+                log::debug("(Argon) Failed to delete {} verification messages: {}", ids.size(), res.unwrapErr());
+            }
+
+            for (size_t i = start; i < end; i++) {
+                finish(batch[i], res.isOk());
+            }
+        }
+
+        storage.finishCleanups(done, failed, MAX_ATTEMPTS);
+
+        auto next = storage.nextCleanupTime(account.accountId, account.serverUrl);
+        if (!next) break;
+
+        auto waitSecs = std::max<int64_t>(*next - unixTimestamp(), 1);
+        if (waitSecs > MAX_SLEEP_SECS) break;
+
+        co_await arc::sleepUntil(asp::Instant::now() + asp::Duration::fromSecs(waitSecs));
+    }
+}
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <argon/argon.hpp>
+#include "util.hpp"
+
+#include <asp/sync/Mutex.hpp>
+#include <unordered_set>
+
+namespace argon {
+
+// Deletes verification messages and comments in the background. The queue itself lives in the data file (see `ArgonStorage`),
+// so deletions that fail or don't get to run before the game is closed are retried later, even in the next session.
+class CleanupQueue : public SingletonBase<CleanupQueue> {
+public:
+    // Starts deleting the pending messages of this account, unless that is already in progress.
+    // `server` is the Argon server the messages were sent for, the requests use its settings.
+    void drain(AccountData account, Server server);
+
+private:
+    friend class SingletonBase;
+
+    asp::Mutex<std::unordered_set<int>> m_draining;
+
+    CleanupQueue() = default;
+    arc::Future<> drainLoop(AccountData account, Server server);
+};
+
+}
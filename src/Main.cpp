@@ -2,6 +2,12 @@
 
 #include "ArgonState.hpp"
 #include "ArgonStorage.hpp"
+#include "AuthFlight.hpp"
+#include "CleanupQueue.hpp"
+#include "PollScheduler.hpp"
+#include "RetryBudget.hpp"
+#include "Troubleshooter.hpp"
+#include "Tracing.hpp"
 #include "Web.hpp"
 
 #include <arc/time/Sleep.hpp>
@@ -60,6 +66,21 @@ std::string_view authProgressToString(AuthProgress progress) {
     }
 }
 
+std::string_view authStageToString(AuthStage stage) {
+    switch (stage) {
+        case AuthStage::Total:
+            return "Total";
+        case AuthStage::RequestChallenge:
+            return "Request challenge";
+        case AuthStage::SubmitSolution:
+            return "Submit solution";
+        case AuthStage::VerifySolution:
+            return "Verify solution";
+        default:
+            return "Unknown";
+    }
+}
+
 AccountData getGameAccountData() {
     requireMainThread("`argon::getGameAccountData` called not in main thread - this is a bug in your mod, GD account data should only be accessed from the main thread.");
 
@@ -102,8 +123,72 @@ bool getCertVerification() {
     return ArgonState::get().getCertVerification();
 }
 
+Server::Server(std::shared_ptr<const ServerConfig> config) : m_config(std::move(config)) {}
+
+Result<Server> Server::create(ServerConfig config) {
+    while (!config.url.empty() && config.url.back() == '/') {
+        config.url.pop_back();
+    }
+
+    if (config.url.empty()) {
+        return Err("Invalid server URL");
+    }
+
+    return Ok(Server{std::make_shared<const ServerConfig>(std::move(config))});
+}
+
+Server Server::current() {
+    // the handle keeps the whole snapshot alive, changing the settings later doesn't affect it
+    auto snapshot = ArgonState::get().config();
+    return Server{std::shared_ptr<const ServerConfig>{snapshot, &snapshot->server}};
+}
+
+const ServerConfig& Server::config() const {
+    return *m_config;
+}
+
+std::string_view Server::url() const {
+    return m_config->url;
+}
+
+std::string Server::makeUrl(std::string_view suffix) const {
+    while (suffix.starts_with('/')) {
+        suffix.remove_prefix(1);
+    }
+
+    return fmt::format("{}/{}", m_config->url, suffix);
+}
+
+void setBackgroundAuth(bool state) {
+    ArgonState::get().setBackgroundAuth(state);
+}
+
+void prewarm() {
+    static std::atomic<int> inProgress{0};
+
+    // one round of prewarming at a time is enough
+    int expected = 0;
+    if (!inProgress.compare_exchange_strong(expected, 2)) return;
+
+    auto warm = [](std::string url, Server server, web::Host host) {
+        arc::spawn([url = std::move(url), server = std::move(server), host](this auto self) -> arc::Future<> {
+            co_await web::prewarmConnection(url, server, host);
+            inProgress--;
+        });
+    };
+
+    // both hosts are warmed up in parallel
+    auto server = Server::current();
+    warm(server.makeUrl(""), server, web::Host::Argon);
+    warm(fmt::format("{}/", web::getBaseServerUrl()), server, web::Host::GD);
+}
+
 void clearAllTokens() {
-    ArgonStorage::get().clearAllTokens();
+    clearAllTokens(Server::current());
+}
+
+void clearAllTokens(const Server& server) {
+    ArgonStorage::get().clearAllTokens(server.url());
 }
 
 void clearToken() {
@@ -111,112 +196,628 @@ void clearToken() {
 }
 
 void clearToken(int accountId) {
-    ArgonStorage::get().clearTokens(accountId);
+    ArgonStorage::get().clearTokens(accountId, Server::current().url());
 }
 
 void clearToken(const AccountData& account) {
     clearToken(account.accountId);
 }
 
+void clearToken(const AccountData& account, const Server& server) {
+    ArgonStorage::get().clearTokens(account.accountId, server.url());
+}
+
 bool hasToken() {
     return hasToken(getGameAccountData());
 }
 
 bool hasToken(const AccountData& account) {
-    return ArgonStorage::get().hasAuthToken(account, getServerUrl());
+    return hasToken(account, Server::current());
+}
+
+bool hasToken(const AccountData& account, const Server& server) {
+    return ArgonStorage::get().hasAuthToken(account, server.url());
+}
+
+static bool hasRemainingLifetime(const StoredToken& token, std::chrono::seconds minLifetime) {
+    // if we don't know when it expires, assume it doesn't
+    if (token.expiresAt == 0 || minLifetime.count() <= 0) {
+        return true;
+    }
+
+    return token.expiresAt - unixTimestamp() >= minLifetime.count();
+}
+
+std::optional<TokenInfo> getTokenInfo(const AccountData& account) {
+    return getTokenInfo(account, Server::current());
+}
+
+std::optional<TokenInfo> getTokenInfo(const AccountData& account, const Server& server) {
+    auto record = ArgonStorage::get().getTokenRecord(account, server.url());
+    if (!record) {
+        return std::nullopt;
+    }
+
+    return TokenInfo {
+        .token = std::move(record->token),
+        .issuedAt = record->issuedAt,
+        .expiresAt = record->expiresAt,
+        .lastValidated = record->validatedAt,
+    };
+}
+
+void markTokenValidated(const AccountData& account) {
+    markTokenValidated(account, Server::current());
+}
+
+void markTokenValidated(const AccountData& account, const Server& server) {
+    ArgonStorage::get().markValidated(account, server.url());
 }
 
+void setDefaultTokenLifetime(std::chrono::seconds lifetime) {
+    ArgonState::get().setDefaultTokenLifetime(lifetime.count());
+}
+
+static Future<> tokenRefreshLoop() {
+    auto& argon = ArgonState::get();
+
+    while (true) {
+        co_await arc::sleepUntil(asp::Instant::now() + asp::Duration::fromSecs(60));
+
+        auto margin = argon.getRefreshMargin();
+        if (margin <= 0) break;
+
+        for (auto& entry : argon.getRefreshEntries()) {
+            auto record = ArgonStorage::get().getTokenRecord(entry.account, entry.server.url());
+
+            // token was cleared since, there's nothing to keep fresh anymore
+            if (!record) {
+                argon.removeRefreshEntry(entry.account, entry.server.url());
+                continue;
+            }
+
+            if (hasRemainingLifetime(*record, std::chrono::seconds(margin))) {
+                continue;
+            }
+
+            log::debug("(Argon) Token for account {} on {} is about to expire, refreshing it", entry.account.username, entry.server.url());
+
+            auto result = co_await startAuth(AuthOptions {
+                .account = entry.account,
+                .minRemainingLifetime = std::chrono::seconds(margin),
+                .server = entry.server,
+            });
+
+            if (!result) {
+                log::warn("(Argon) Failed to refresh token: {}", result.unwrapErr());
+            }
+        }
+    }
+
+    argon.refresherStopped();
+}
+
+void setTokenRefresh(bool enabled, std::chrono::seconds margin) {
+    auto& argon = ArgonState::get();
+    argon.setRefreshMargin(enabled ? std::max<int64_t>(margin.count(), 1) : 0);
+
+    if (enabled && !argon.hasDefaultTokenLifetime()) {
+        log::warn("(Argon) Token refresh was enabled without a default token lifetime, it only affects servers that report token expiry");
+    }
+
+    if (enabled && argon.tryStartRefresher()) {
+        arc::spawn([](this auto self) -> arc::Future<> {
+            co_await tokenRefreshLoop();
+        });
+    }
+}
+
+void setAuthSpanSink(AuthSpanSink sink) {
+    Tracer::get().setSink(std::move(sink));
+}
+
+AuthStageStats getAuthStageStats(AuthStage stage) {
+    return Tracer::get().stats(stage);
+}
+
+AuthStats getAuthStats() {
+    return ArgonState::get().getStats();
+}
+
+void setBinaryStorage(bool state) {
+    ArgonStorage::get().setBinaryStorage(state);
+}
+
+
+CancellationToken::CancellationToken() : m_state(std::make_shared<std::atomic<bool>>(false)) {}
+
+void CancellationToken::cancel() {
+    m_state->store(true, std::memory_order::release);
+}
+
+bool CancellationToken::cancelled() const {
+    return m_state->load(std::memory_order::acquire);
+}
 
 AuthFuture startAuth(AccountData data) {
     return startAuth(AuthOptions{ .account = std::move(data) });
 }
 
-inline std::string solveChallenge(int value) {
-    return fmt::to_string(value ^ 0x5F3759DF);
+static AuthMethod methodFromString(std::string_view method) {
+    return method == "comment" ? AuthMethod::Comment : AuthMethod::Message;
 }
 
-static Future<Result<>> submitSolution(const AccountData& account, std::string_view solution, int id) {
-    auto text = fmt::format("#ARGON# {}", solution);
+static Future<Result<>> submitSolution(const Server& server, const AccountData& account, std::string_view solution, AuthMethod method, int id, web::RequestMeta* meta) {
+    auto text = core::solutionText(solution);
+
+    if (method == AuthMethod::Comment) {
+        co_return co_await web::submitGDComment(server, account, id, text, meta);
+    }
 
-    return web::submitGDMessage(account, id, text);
+    co_return co_await web::submitGDMessage(server, account, id, text, meta);
 }
 
-static Future<std::string> troubleshootFailureCause(const AccountData& account) {
-    auto result = co_await web::checkGDMessageLimit(account);
-    if (result.isErr()) {
-        co_return std::move(result).unwrapErr();
-    }
-    co_return "Stage 2 failed due to unknown error, auth and message limit are OK";
+// Checks the message limit in the background, awaiting the returned handle gives whether it was reached, or nullopt if the check failed
+static auto startMessageLimitPrecheck(const Server& server, const AccountData& account) {
+    return arc::spawn([server, account](this auto self) -> arc::Future<std::optional<bool>> {
+        auto result = co_await web::checkGDAccount(server, account);
+        if (!result) {
+            co_return std::nullopt;
+        }
+
+        co_return result.unwrap() == web::GDAccountStatus::MessageLimitReached;
+    });
 }
 
-AuthFuture startAuth(AuthOptions options) {
-    if (!options.account.valid()) {
-        co_return Err("Invalid account data");
+Future<AuthDiagnosis> diagnoseAuthFailure(AccountData account, Server server) {
+    return runTroubleshooter(std::move(account), std::move(server));
+}
+
+// Sleeps until the given time, returns false early if the auth gets cancelled in the meantime
+static Future<bool> sleepCancellable(asp::Instant until, const CancellationToken& cancel) {
+    // there's nothing to subscribe to, so wake up every now and then to check the flag
+    while (true) {
+        if (cancel.cancelled()) {
+            co_return false;
+        }
+
+        auto now = asp::Instant::now();
+        if (now >= until) {
+            co_return true;
+        }
+
+        co_await arc::sleepUntil(std::min(until, now + asp::Duration::fromMillis(100)));
     }
+}
 
-    auto& argon = ArgonState::get();
+// Runs a stage until it succeeds, fails with an error that isn't worth retrying, or runs out of retries.
+// All requests made by `attempt` must be recorded into `meta`.
+template <typename F>
+static auto retryStage(
+    AuthOptions& options,
+    const RetryBudget& budget,
+    const RetryPolicy& policy,
+    AuthProgress retryProgress,
+    TraceSpan& span,
+    web::RequestMeta& meta,
+    F attempt
+) -> decltype(attempt()) {
+    for (uint32_t retry = 1;; retry++) {
+        size_t requestsBefore = meta.requests;
+        auto result = co_await attempt();
+
+        if (result || !isTransientFailure(meta, requestsBefore)) {
+            co_return result;
+        }
+
+        auto delay = budget.delayFor(policy, retry);
+        if (!delay) {
+            co_return result;
+        }
+
+        log::debug("(Argon) Request failed ({}), retrying in {}", result.unwrapErr(), delay->toString());
 
-    // use cached token if possible
-    if (auto token = ArgonStorage::get().getAuthToken(options.account, argon.getServerUrl())) {
-        log::debug("(Argon) Using cached auth token for account {}", options.account.username);
-        co_return Ok(std::move(*token));
+        span.addRetry();
+        if (options.progress) options.progress(retryProgress);
+
+        if (!co_await sleepCancellable(asp::Instant::now() + *delay, options.cancel)) {
+            co_return Err("Authentication was cancelled");
+        }
     }
+}
+
+static AuthFuture runAuth(AuthOptions& options) {
+    auto& argon = ArgonState::get();
+    auto& server = *options.server;
 
     auto progress = [&](AuthProgress p) {
         if (options.progress) options.progress(p);
     };
 
-    progress(AuthProgress::RequestedChallenge);
-    ARC_CO_UNWRAP_INTO(auto s1data, co_await web::startChallenge(options.account, "message", options.forceStrong));
+    int accountId = options.account.accountId;
+    RetryBudget budget{options.retry.budget};
+
+    // in auto mode, find out whether the account can still send messages while the challenge is being requested
+    std::optional<decltype(startMessageLimitPrecheck(server, options.account))> precheck;
+    if (options.method == AuthMethod::Auto) {
+        precheck.emplace(startMessageLimitPrecheck(server, options.account));
+    }
+
+    auto requestChallenge = [&](std::string_view method) -> Future<Result<web::Stage1ResponseData>> {
+        progress(AuthProgress::RequestedChallenge);
+
+        TraceSpan span{AuthStage::RequestChallenge, accountId};
+        web::RequestMeta meta;
+        auto result = co_await retryStage(options, budget, options.retry.request, AuthProgress::RetryingRequest, span, meta, [&] {
+            return web::startChallenge(server, options.account, method, options.forceStrong, &meta);
+        });
+        span.addRequest(meta);
+        span.end(result);
+
+        co_return result;
+    };
+
+    std::string solution;
+    std::optional<web::SuccessfulVerification> earlyVerification;
+
+    auto submitChallenge = [&](const web::Stage1ResponseData& s1data) -> Future<Result<>> {
+        progress(AuthProgress::SolvingChallenge);
+        solution = core::solveChallenge(s1data.challenge);
+
+        TraceSpan span{AuthStage::SubmitSolution, accountId};
+        web::RequestMeta meta;
+
+        // sending a message or comment is not idempotent, if we don't know whether the last attempt went through,
+        // ask the server before sending another one
+        bool lastAttemptAmbiguous = false;
+
+        auto result = co_await retryStage(options, budget, options.retry.solve, AuthProgress::RetryingSolve, span, meta, [&]() -> Future<Result<>> {
+            if (lastAttemptAmbiguous) {
+                web::RequestMeta probeMeta;
+                auto probe = co_await web::verifyChallenge(server, options.account, s1data.challengeId, solution, &probeMeta);
+                span.addRequest(probeMeta);
+
+                if (probe && std::holds_alternative<web::SuccessfulVerification>(probe.unwrap())) {
+                    earlyVerification = std::get<web::SuccessfulVerification>(std::move(probe).unwrap());
+                    co_return Ok();
+                }
+            }
+
+            auto sent = co_await submitSolution(server, options.account, solution, methodFromString(s1data.method), s1data.id, &meta);
+            lastAttemptAmbiguous = !sent && isAmbiguousFailure(meta);
+            co_return sent;
+        });
+        span.addRequest(meta);
+        span.end(result);
+
+        co_return result;
+    };
+
+    auto preferred = options.method == AuthMethod::Comment ? "comment" : "message";
+    ARC_CO_UNWRAP_INTO(auto s1data, co_await requestChallenge(preferred));
+
+    if (precheck && methodFromString(s1data.method) == AuthMethod::Message) {
+        // the check was started at the same time as the challenge request, so usually it's done by now
+        auto reached = co_await *precheck;
+
+        if (options.cancel.cancelled()) {
+            co_return Err("Authentication was cancelled");
+        }
+
+        if (reached.value_or(false)) {
+            log::debug("(Argon) Sent message limit reached, using comment auth instead");
+            ARC_CO_UNWRAP_INTO(s1data, co_await requestChallenge("comment"));
+        }
+    }
+
+    if (options.cancel.cancelled()) {
+        co_return Err("Authentication was cancelled");
+    }
 
-    // TODO: in future try falling back to comment auth
+    auto s2res = co_await submitChallenge(s1data);
+
+    if (!s2res && options.method == AuthMethod::Auto && methodFromString(s1data.method) == AuthMethod::Message && !options.cancel.cancelled()) {
+        log::debug("(Argon) Failed to send the message ({}), trying comment auth instead", s2res.unwrapErr());
+
+        auto commentRes = co_await requestChallenge("comment");
+        if (commentRes) {
+            s1data = std::move(commentRes).unwrap();
+            s2res = co_await submitChallenge(s1data);
+        }
+    }
 
-    progress(AuthProgress::SolvingChallenge);
-    auto solution = solveChallenge(s1data.challenge);
-    auto s2res = co_await submitSolution(options.account, solution, s1data.id);
     if (!s2res) {
-        co_return Err(co_await troubleshootFailureCause(options.account));
+        if (methodFromString(s1data.method) == AuthMethod::Comment) {
+            co_return Err(std::move(s2res).unwrapErr());
+        }
+
+        auto diagnosis = co_await runTroubleshooter(options.account, server);
+        if (options.diagnosis) options.diagnosis(diagnosis);
+
+        co_return Err(std::move(diagnosis.message));
+    }
+
+    if (options.cancel.cancelled()) {
+        co_return Err("Authentication was cancelled");
     }
 
     progress(AuthProgress::VerifyingChallenge);
-    ARC_CO_UNWRAP_INTO(auto vdata, co_await web::verifyChallenge(options.account, s1data.challengeId, solution));
 
-    auto startedAt = asp::Instant::now();
-    auto latestDeadline = startedAt + asp::Duration::fromSecs(30);
+    // one span for the whole verification, every poll is added to it
+    TraceSpan s3span{AuthStage::VerifySolution, accountId};
+    web::RequestMeta s3meta;
+    PollScheduler scheduler{options.poll};
+
+    auto endVerify = [&](bool success, std::string error = {}) {
+        s3span.addRequest(s3meta);
+        s3span.setPollIterations(scheduler.iterations());
+        s3span.end(success, std::move(error));
+    };
+
+    auto failVerify = [&](std::string error) {
+        endVerify(false, error);
+        return Err(std::move(error));
+    };
+
+    auto vres = earlyVerification
+        ? web::VerifyResult(Ok(web::VerifyData{std::move(*earlyVerification)}))
+        : co_await retryStage(options, budget, options.retry.verify, AuthProgress::RetryingVerify, s3span, s3meta, [&] {
+            return web::verifyChallenge(server, options.account, s1data.challengeId, solution, &s3meta);
+        });
+
+    if (!vres) {
+        co_return failVerify(std::move(vres).unwrapErr());
+    }
+
+    auto vdata = std::move(vres).unwrap();
 
     while (std::holds_alternative<web::PollLater>(vdata)) {
         auto& plater = std::get<web::PollLater>(vdata);
-        auto waitTime = asp::Duration::fromMillis(plater.ms);
-        auto now = asp::Instant::now();
-
-        // take no longer than 30 seconds
-        auto deadline = std::min(
-            now + waitTime,
-            latestDeadline
-        );
+        auto waitTime = scheduler.nextDelay(plater.ms);
 
         log::debug("(Argon) Waiting for {} and polling again..", waitTime.toString());
-        co_await arc::sleepUntil(deadline);
 
-        now = asp::Instant::now();
-        if (now >= latestDeadline) {
-            co_return Err("Server did not verify the solution in a reasonable amount of time");
+        // don't sleep past the deadline
+        auto wakeAt = std::min(asp::Instant::now() + waitTime, scheduler.deadline());
+        if (!co_await sleepCancellable(wakeAt, options.cancel)) {
+            co_return failVerify("Authentication was cancelled");
+        }
+
+        if (scheduler.expired()) {
+            co_return failVerify("Server did not verify the solution in a reasonable amount of time");
         }
 
         // poll again
-        ARC_CO_UNWRAP_INTO(vdata, co_await web::verifyChallengePoll(options.account, s1data.challengeId, solution));
+        vres = co_await retryStage(options, budget, options.retry.verify, AuthProgress::RetryingVerify, s3span, s3meta, [&] {
+            return web::verifyChallengePoll(server, options.account, s1data.challengeId, solution, &s3meta);
+        });
+        if (!vres) {
+            co_return failVerify(std::move(vres).unwrapErr());
+        }
+
+        vdata = std::move(vres).unwrap();
     }
 
+    endVerify(true);
+
     auto& verif = std::get<web::SuccessfulVerification>(vdata);
-    argon.handleSuccessfulAuth(options.account, verif.authtoken, s1data.ident, verif.commentId);
+    argon.handleSuccessfulAuth(options.account, server, verif.authtoken, s1data.ident, verif.commentId, verif.expiresIn, methodFromString(s1data.method), s1data.id);
 
     co_return Ok(std::move(verif.authtoken));
 }
 
+AuthFuture startAuth(AuthOptions options) {
+    if (!options.account.valid()) {
+        co_return Err("Invalid account data");
+    }
+
+    if (!options.server) {
+        options.server = Server::current();
+    }
+
+    auto& argon = ArgonState::get();
+    auto serverUrl = options.server->url();
+
+    // remember the account so the refresher knows whose token to keep fresh, and on which server
+    if (argon.getRefreshMargin() > 0) {
+        argon.addRefreshEntry(options.account, *options.server);
+    }
+
+    while (true) {
+        // use cached token if possible
+        auto record = ArgonStorage::get().getTokenRecord(options.account, serverUrl);
+        if (record && hasRemainingLifetime(*record, options.minRemainingLifetime)) {
+            log::debug("(Argon) Using cached auth token for account {}", options.account.username);
+            argon.counters().cached.fetch_add(1, std::memory_order::relaxed);
+            co_return Ok(std::move(record->token));
+        }
+
+        // if this account is already being authenticated (possibly by another mod), wait for that instead of sending another message
+        auto flight = AuthFlightHandle::join(serverUrl, options);
+
+        if (flight.isLeader()) {
+            auto& counters = argon.counters();
+            counters.started.fetch_add(1, std::memory_order::relaxed);
+
+            TraceSpan span{AuthStage::Total, options.account.accountId};
+            auto result = co_await runAuth(options);
+            span.end(result);
+
+            (result ? counters.succeeded : counters.failed).fetch_add(1, std::memory_order::relaxed);
+
+            // if we were cancelled, let anyone waiting on us take over instead of failing them too
+            if (!options.cancel.cancelled()) {
+                flight.finish(result);
+            }
+
+            co_return result;
+        }
+
+        log::debug("(Argon) Auth for account {} is already in progress, waiting for it", options.account.username);
+        argon.counters().joined.fetch_add(1, std::memory_order::relaxed);
+
+        auto result = co_await flight.wait();
+
+        // the new token may be too short-lived for us, in which case the cache check fails and we authenticate ourselves
+        if (result && result->isOk() && options.minRemainingLifetime.count() > 0) {
+            continue;
+        }
+
+        if (result) {
+            co_return std::move(*result);
+        }
+
+        // the other auth was cancelled before finishing, try again
+    }
+}
+
+// Shared between the workers of one bulk authentication
+struct BulkAuthState {
+    BulkAuthOptions options;
+    // indices of the accounts that need to go through the whole auth
+    std::vector<size_t> pending;
+    std::atomic<size_t> nextPending{0};
+    asp::Mutex<std::vector<std::optional<Result<std::string>>>> results;
+
+    void finish(size_t index, Result<std::string> result, bool cached) {
+        // the callback is called with the lock held, so that it never runs concurrently
+        auto results = this->results.lock();
+
+        if (options.onResult) {
+            options.onResult(BulkAuthResult {
+                .index = index,
+                .account = options.accounts[index],
+                .result = result,
+                .cached = cached,
+            });
+        }
+
+        (*results)[index] = std::move(result);
+    }
+};
+
+static Future<> bulkAuthWorker(std::shared_ptr<BulkAuthState> state) {
+    auto& options = state->options;
+
+    while (true) {
+        size_t slot = state->nextPending.fetch_add(1, std::memory_order::relaxed);
+        if (slot >= state->pending.size()) break;
+
+        size_t index = state->pending[slot];
+
+        if (options.cancel.cancelled()) {
+            state->finish(index, Err("Authentication was cancelled"), false);
+            continue;
+        }
+
+        auto result = co_await startAuth(AuthOptions {
+            .account = options.accounts[index],
+            .forceStrong = options.forceStrong,
+            .method = options.method,
+            .poll = options.poll,
+            .retry = options.retry,
+            .cancel = options.cancel,
+            .minRemainingLifetime = options.minRemainingLifetime,
+            .server = options.server,
+        });
+
+        state->finish(index, std::move(result), false);
+    }
+}
+
+static auto spawnBulkAuthWorker(std::shared_ptr<BulkAuthState> state) {
+    return arc::spawn([state = std::move(state)](this auto self) -> arc::Future<> {
+        co_await bulkAuthWorker(state);
+    });
+}
+
+Future<std::vector<Result<std::string>>> startBulkAuth(BulkAuthOptions options) {
+    if (!options.server) {
+        options.server = Server::current();
+    }
+
+    auto state = std::make_shared<BulkAuthState>();
+    state->options = std::move(options);
+
+    auto& accounts = state->options.accounts;
+    state->results.lock()->resize(accounts.size());
+
+    // answer everything that can be answered from the storage first, so those accounts don't wait for a free slot
+    for (size_t i = 0; i < accounts.size(); i++) {
+        auto& account = accounts[i];
+
+        if (!account.valid()) {
+            state->finish(i, Err("Invalid account data"), false);
+            continue;
+        }
+
+        auto record = ArgonStorage::get().getTokenRecord(account, state->options.server->url());
+        if (record && hasRemainingLifetime(*record, state->options.minRemainingLifetime)) {
+            ArgonState::get().counters().cached.fetch_add(1, std::memory_order::relaxed);
+            state->finish(i, Ok(std::move(record->token)), true);
+            continue;
+        }
+
+        state->pending.push_back(i);
+    }
+
+    size_t workers = std::min(std::max<size_t>(state->options.maxConcurrent, 1), state->pending.size());
+
+    log::debug("(Argon) Bulk auth of {} accounts, {} need authentication", accounts.size(), state->pending.size());
+
+    std::vector<decltype(spawnBulkAuthWorker(state))> handles;
+    handles.reserve(workers);
+
+    for (size_t i = 0; i < workers; i++) {
+        handles.push_back(spawnBulkAuthWorker(state));
+    }
+
+    // every worker runs until the queue is empty, so once all of them have returned every account has a result
+    for (auto& handle : handles) {
+        co_await handle;
+    }
+
+    std::vector<Result<std::string>> out;
+    out.reserve(accounts.size());
+
+    auto results = state->results.lock();
+    for (auto& result : *results) {
+        out.push_back(std::move(*result));
+    }
+
+    co_return out;
+}
+
+static void startBackgroundAuth() {
+    if (!signedIn()) return;
+
+    // account data can only be collected here on the main thread, the rest happens in the background
+    auto account = getGameAccountData();
+    if (!account.valid() || hasToken(account)) return;
+
+    log::debug("(Argon) Starting background authentication for account {}", account.username);
+
+    arc::spawn([account = std::move(account)](this auto self) -> arc::Future<> {
+        auto result = co_await startAuth(account);
+        if (!result) {
+            log::warn("(Argon) Background authentication failed: {}", result.unwrapErr());
+        }
+    });
+}
+
 $execute {
     ModStateEvent(ModEventType::Loaded, Mod::get()).listen([] {
         g_mainThreadId = std::this_thread::get_id();
         ArgonState::get().initConfigLock();
+
+        if (ArgonState::get().getBackgroundAuth()) {
+            startBackgroundAuth();
+        }
+
+        // finish deleting verification messages left over from previous sessions
+        if (signedIn()) {
+            CleanupQueue::get().drain(getGameAccountData(), Server::current());
+        }
     }, -10000).leak();
 }
 
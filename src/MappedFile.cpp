@@ -0,0 +1,119 @@
+#include "MappedFile.hpp"
+
+#include <Geode/platform/platform.hpp>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#ifdef GEODE_IS_WINDOWS
+# ifndef WIN32_LEAN_AND_MEAN
+#  define WIN32_LEAN_AND_MEAN
+# endif
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
+# include <Windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace argon {
+
+geode::Result<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    MappedFile file;
+
+#ifdef GEODE_IS_WINDOWS
+    HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return geode::Err("failed to open file (error {})", GetLastError());
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        CloseHandle(handle);
+        return geode::Err("failed to get file size or file is empty");
+    }
+
+    HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(handle);
+
+    if (!mapping) {
+        return geode::Err("failed to create file mapping (error {})", GetLastError());
+    }
+
+    // the view keeps the mapping alive
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+
+    if (!view) {
+        return geode::Err("failed to map file (error {})", GetLastError());
+    }
+
+    file.m_data = static_cast<const uint8_t*>(view);
+    file.m_size = (size_t) size.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return geode::Err("failed to open file: {}", std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return geode::Err("failed to stat file or file is empty");
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (addr == MAP_FAILED) {
+        return geode::Err("failed to map file: {}", std::strerror(errno));
+    }
+
+    file.m_data = static_cast<const uint8_t*>(addr);
+    file.m_size = (size_t) st.st_size;
+#endif
+
+    return geode::Ok(std::move(file));
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        this->reset();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    this->reset();
+}
+
+std::span<const uint8_t> MappedFile::data() const {
+    return {m_data, m_size};
+}
+
+void MappedFile::reset() {
+    if (!m_data) return;
+
+#ifdef GEODE_IS_WINDOWS
+    UnmapViewOfFile(m_data);
+#else
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+}
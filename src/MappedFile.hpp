@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Geode/Result.hpp>
+#include <filesystem>
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace argon {
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+    static geode::Result<MappedFile> open(const std::filesystem::path& path);
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    std::span<const uint8_t> data() const;
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+
+    MappedFile() = default;
+    void reset();
+};
+
+}
@@ -0,0 +1,41 @@
+#include "PollScheduler.hpp"
+#include <algorithm>
+
+namespace argon {
+
+PollScheduler::PollScheduler(const VerifyPollOptions& options)
+    : m_options(options),
+      m_deadline(asp::Instant::now() + asp::Duration::fromMillis(options.deadline.count())),
+      m_currentMs(options.initialDelay.count()),
+      m_rng(std::random_device{}()) {}
+
+asp::Duration PollScheduler::nextDelay(uint32_t serverDelayMs) {
+    double maxMs = std::max<double>(m_options.maxDelay.count(), 0.0);
+    double delayMs = std::min(m_currentMs, maxMs);
+
+    if (m_options.jitter > 0.0) {
+        std::uniform_real_distribution<double> dist(-m_options.jitter, m_options.jitter);
+        delayMs += delayMs * dist(m_rng);
+    }
+
+    m_currentMs = std::min(m_currentMs * std::max(m_options.backoffFactor, 1.0), maxMs);
+    m_iterations++;
+
+    delayMs = std::max(delayMs, (double) serverDelayMs);
+
+    return asp::Duration::fromMillis((uint64_t) std::max(delayMs, 0.0));
+}
+
+asp::Instant PollScheduler::deadline() const {
+    return m_deadline;
+}
+
+bool PollScheduler::expired() const {
+    return asp::Instant::now() >= m_deadline;
+}
+
+size_t PollScheduler::iterations() const {
+    return m_iterations;
+}
+
+}
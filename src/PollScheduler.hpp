@@ -0,0 +1,29 @@
+#pragma once
+#include <argon/argon.hpp>
+#include <asp/time/Duration.hpp>
+#include <asp/time/Instant.hpp>
+#include <random>
+
+namespace argon {
+
+// Decides how long to wait between verification polls, see `VerifyPollOptions`
+class PollScheduler {
+public:
+    PollScheduler(const VerifyPollOptions& options);
+
+    // Returns the delay before the next poll, never shorter than what the server asked for
+    asp::Duration nextDelay(uint32_t serverDelayMs);
+
+    asp::Instant deadline() const;
+    bool expired() const;
+    size_t iterations() const;
+
+private:
+    VerifyPollOptions m_options;
+    asp::Instant m_deadline;
+    double m_currentMs;
+    size_t m_iterations = 0;
+    std::minstd_rand m_rng;
+};
+
+}
@@ -0,0 +1,188 @@
+#include "RequestScheduler.hpp"
+#include "ArgonState.hpp"
+
+#include <arc/time/Sleep.hpp>
+#include <asp/time/Duration.hpp>
+#include <asp/time/Instant.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+
+using namespace geode::prelude;
+
+namespace argon {
+
+namespace {
+
+// What `impl` points to, only ever touched by the copy that created the scheduler
+struct SchedulerImpl {
+    std::mutex mutex;
+    std::unordered_map<std::string, SharedHostState> hosts;
+};
+
+}
+
+static constexpr SharedRequestSchedulerFns SCHEDULER_FNS = {
+    .withHost = [](SharedRequestScheduler* shared, SharedStr host, void (*fn)(SharedHostState* state, void* ctx), void* ctx) {
+        auto& impl = *static_cast<SchedulerImpl*>(shared->impl);
+        std::lock_guard lock(impl.mutex);
+
+        fn(&impl.hosts[std::string{host.data, host.size}], ctx);
+    },
+};
+
+SharedRequestScheduler::SharedRequestScheduler() : fns(&SCHEDULER_FNS), impl(new SchedulerImpl{}) {}
+
+// Runs `fn(SharedHostState&)` with the host's state locked, whichever copy of argon owns the scheduler
+template <typename F>
+static void withHost(std::string_view host, F fn) {
+    auto& shared = ArgonState::get().getRequestScheduler();
+
+    shared.fns->withHost(&shared, SharedStr{host.data(), host.size()}, [](SharedHostState* state, void* ctx) {
+        (*static_cast<F*>(ctx))(*state);
+    }, &fn);
+}
+
+// GD servers start refusing requests from an IP that sends too many of them, these limits stay well below that
+static constexpr uint32_t MAX_IN_FLIGHT = 2;
+static constexpr double REQUESTS_PER_SEC = 2.0;
+static constexpr double BURST = 4.0;
+
+// How long to back off after a 429 without a Retry-After, and the most we'll ever wait
+static constexpr int64_t DEFAULT_BACKOFF_SECS = 5;
+static constexpr int64_t MAX_BACKOFF_SECS = 120;
+
+// Upper bound for a single sleep while waiting, slots freed by other requests are noticed within this time
+static constexpr int64_t MAX_POLL_MS = 50;
+
+static int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string hostOf(std::string_view url) {
+    auto start = url.find("://");
+    start = start == std::string_view::npos ? 0 : start + 3;
+
+    auto end = url.find('/', start);
+    return std::string{url.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start)};
+}
+
+static void refill(SharedHostState& state, int64_t now) {
+    // a host we haven't talked to yet starts with a full bucket
+    if (state.lastRefill == 0) {
+        state.tokens = BURST;
+    } else {
+        state.tokens = std::min(BURST, state.tokens + (double) (now - state.lastRefill) * REQUESTS_PER_SEC / 1000.0);
+    }
+
+    state.lastRefill = now;
+}
+
+// Takes a slot and a token if possible and returns 0, otherwise returns how long to wait before trying again
+static int64_t tryStart(SharedHostState& state, bool interactive, int64_t now) {
+    refill(state, now);
+
+    if (now < state.blockedUntil) {
+        return state.blockedUntil - now;
+    }
+
+    if (!interactive && state.interactiveWaiting > 0) {
+        return MAX_POLL_MS;
+    }
+
+    // background requests never take the last slot, so an interactive one can always start right away
+    uint32_t cap = interactive ? MAX_IN_FLIGHT : std::max<uint32_t>(MAX_IN_FLIGHT - 1, 1);
+    if (state.inFlight >= cap) {
+        return MAX_POLL_MS;
+    }
+
+    if (state.tokens < 1.0) {
+        return (int64_t) std::ceil((1.0 - state.tokens) * 1000.0 / REQUESTS_PER_SEC);
+    }
+
+    state.tokens -= 1.0;
+    state.inFlight++;
+
+    return 0;
+}
+
+// Counts an interactive request as waiting for as long as it exists, even if the future waiting for the permit is dropped
+class InteractiveWaiter {
+public:
+    InteractiveWaiter(std::string_view host) : m_host(host) {
+        withHost(m_host, [](SharedHostState& state) { state.interactiveWaiting++; });
+    }
+
+    ~InteractiveWaiter() {
+        withHost(m_host, [](SharedHostState& state) { state.interactiveWaiting--; });
+    }
+
+    InteractiveWaiter(const InteractiveWaiter&) = delete;
+    InteractiveWaiter& operator=(const InteractiveWaiter&) = delete;
+
+private:
+    std::string m_host;
+};
+
+RequestPermit::RequestPermit(std::string host) : m_host(std::move(host)), m_active(true) {}
+
+RequestPermit::RequestPermit(RequestPermit&& other)
+    : m_host(std::move(other.m_host)), m_active(std::exchange(other.m_active, false)) {}
+
+RequestPermit::~RequestPermit() {
+    if (!m_active) return;
+
+    withHost(m_host, [](SharedHostState& state) { state.inFlight--; });
+}
+
+void RequestPermit::finish(int code, std::optional<int64_t> retryAfterSecs) {
+    if (!m_active) return;
+    m_active = false;
+
+    bool limited = code == 429 || (code == 503 && retryAfterSecs);
+    int64_t backoff = std::clamp<int64_t>(retryAfterSecs.value_or(DEFAULT_BACKOFF_SECS), 1, MAX_BACKOFF_SECS);
+
+    withHost(m_host, [&](SharedHostState& state) {
+        state.inFlight--;
+
+        if (limited) {
+            state.blockedUntil = std::max(state.blockedUntil, nowMs() + backoff * 1000);
+            state.tokens = 0.0;
+        }
+    });
+
+    if (!limited) {
+        return;
+    }
+
+    log::warn("(Argon) {} is rate limiting us (code {}), holding off requests for {}s", m_host, code, backoff);
+}
+
+arc::Future<RequestPermit> acquireRequestPermit(std::string_view url, RequestPriority priority) {
+    auto host = hostOf(url);
+
+    std::optional<InteractiveWaiter> waiter;
+    if (priority == RequestPriority::Interactive) {
+        waiter.emplace(host);
+    }
+
+    while (true) {
+        int64_t waitMs = 0;
+        bool interactive = waiter.has_value();
+
+        withHost(host, [&](SharedHostState& state) {
+            waitMs = tryStart(state, interactive, nowMs());
+        });
+
+        if (waitMs == 0) {
+            co_return RequestPermit{std::move(host)};
+        }
+
+        // other copies of argon can free up slots too, so there's nothing to subscribe to, just check again in a bit
+        co_await arc::sleepUntil(asp::Instant::now() + asp::Duration::fromMillis(std::min(waitMs, MAX_POLL_MS)));
+    }
+}
+
+}
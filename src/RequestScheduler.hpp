@@ -0,0 +1,87 @@
+#pragma once
+#include "SharedTokenTable.hpp"
+#include <argon/argon.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <stdint.h>
+
+namespace argon {
+
+enum class RequestPriority : uint8_t {
+    // Part of an authentication someone is waiting for
+    Interactive,
+    // Can wait, e.g. deleting verification messages. Yields to interactive requests to the same host.
+    Background,
+};
+
+// Pacing state of one host. Times are milliseconds of the steady clock.
+struct SharedHostState {
+    uint32_t inFlight = 0;
+    uint32_t interactiveWaiting = 0;
+    // Token bucket, one token per request
+    double tokens = 0.0;
+    int64_t lastRefill = 0;
+    // Set after the host asked us to slow down, nothing is sent to it before this time
+    int64_t blockedUntil = 0;
+};
+
+struct SharedRequestScheduler;
+
+// Implemented by the copy of Argon that created the scheduler, thread-safe
+struct SharedRequestSchedulerFns {
+    // Calls `fn` with the state of the host while holding the scheduler's mutex, a host seen for the first time starts zeroed.
+    // `fn` must not throw or call back into the scheduler.
+    void (*withHost)(SharedRequestScheduler* shared, SharedStr host, void (*fn)(SharedHostState* state, void* ctx), void* ctx);
+};
+
+// Outbound requests to GD servers, keyed by host. Shared between every copy of Argon loaded into the game,
+// same rules apply as for `SharedTokenTable`, except that it's protected by its own mutex inside `impl`.
+struct SharedRequestScheduler {
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t version = VERSION;
+    uint32_t size = sizeof(SharedRequestScheduler);
+    const SharedRequestSchedulerFns* fns;
+    void* impl;
+
+    // Only ever runs in the copy that creates the scheduler, the storage behind `impl` is never freed
+    SharedRequestScheduler();
+};
+
+static_assert(SharedRequestScheduler::VERSION == 1 && std::is_standard_layout_v<SharedRequestScheduler>);
+static_assert(sizeof(SharedHostState) == 32);
+#if SIZE_MAX == UINT64_MAX
+static_assert(sizeof(SharedRequestSchedulerFns) == sizeof(void*));
+static_assert(sizeof(SharedRequestScheduler) == 24);
+#endif
+
+// Allows one request to be in flight. Must be kept alive until the response has arrived.
+class RequestPermit {
+public:
+    RequestPermit(RequestPermit&& other);
+    RequestPermit& operator=(RequestPermit&&) = delete;
+    ~RequestPermit();
+
+    // Records the response, and frees the slot. If the host responded with 429, or sent a `Retry-After` with a 503,
+    // every copy of Argon holds off sending anything to it for a while.
+    void finish(int code, std::optional<int64_t> retryAfterSecs);
+
+private:
+    friend arc::Future<RequestPermit> acquireRequestPermit(std::string_view url, RequestPriority priority);
+
+    std::string m_host;
+    bool m_active = false;
+
+    RequestPermit(std::string host);
+};
+
+// Waits until a request to the host of this URL can be sent without exceeding its concurrency cap or request rate.
+// Applies to all copies of Argon together, so many mods starting up at once don't get the user's IP rate limited.
+arc::Future<RequestPermit> acquireRequestPermit(std::string_view url, RequestPriority priority);
+
+// e.g. "www.boomlings.com" for "https://www.boomlings.com/database"
+std::string hostOf(std::string_view url);
+
+}
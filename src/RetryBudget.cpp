@@ -0,0 +1,41 @@
+#include "RetryBudget.hpp"
+#include "Web.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace argon {
+
+bool isTransientFailure(const web::RequestMeta& meta, size_t requestsBefore) {
+    // failed before anything was sent, retrying won't help
+    if (meta.requests == requestsBefore) {
+        return false;
+    }
+
+    return meta.code < 100 || meta.code == 429 || meta.code >= 500;
+}
+
+bool isAmbiguousFailure(const web::RequestMeta& meta) {
+    return meta.code < 100;
+}
+
+RetryBudget::RetryBudget(std::chrono::milliseconds budget)
+    : m_deadline(asp::Instant::now() + asp::Duration::fromMillis(std::max<int64_t>(budget.count(), 0))) {}
+
+std::optional<asp::Duration> RetryBudget::delayFor(const RetryPolicy& policy, uint32_t retry) const {
+    if (retry == 0 || retry >= policy.maxAttempts) {
+        return std::nullopt;
+    }
+
+    double delayMs = policy.initialDelay.count() * std::pow(std::max(policy.backoffFactor, 1.0), retry - 1);
+    delayMs = std::clamp<double>(delayMs, 0.0, std::max<double>(policy.maxDelay.count(), 0.0));
+
+    auto delay = asp::Duration::fromMillis((uint64_t) delayMs);
+
+    if (asp::Instant::now() + delay >= m_deadline) {
+        return std::nullopt;
+    }
+
+    return delay;
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <argon/argon.hpp>
+#include <asp/time/Duration.hpp>
+#include <asp/time/Instant.hpp>
+#include <optional>
+
+namespace argon {
+
+namespace web {
+    struct RequestMeta;
+}
+
+// Whether the last request recorded in `meta` failed in a way that is worth retrying.
+// `requestsBefore` is the amount of requests recorded before the attempt was made.
+bool isTransientFailure(const web::RequestMeta& meta, size_t requestsBefore);
+
+// Whether the last request recorded in `meta` failed without any response, so it may or may not have been processed
+bool isAmbiguousFailure(const web::RequestMeta& meta);
+
+// Decides whether and when a failed stage is retried, shared by all stages of one authentication
+class RetryBudget {
+public:
+    RetryBudget(std::chrono::milliseconds budget);
+
+    // Returns the delay before the given retry of a stage (1 for the first retry),
+    // or nothing if the stage has run out of attempts or the budget is used up
+    std::optional<asp::Duration> delayFor(const RetryPolicy& policy, uint32_t retry) const;
+
+private:
+    asp::Instant m_deadline;
+};
+
+}
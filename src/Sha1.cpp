@@ -0,0 +1,98 @@
+#include "Sha1.hpp"
+#include <array>
+#include <bit>
+#include <stdint.h>
+
+namespace argon {
+
+static void processBlock(std::array<uint32_t, 5>& state, const uint8_t* block) {
+    uint32_t w[80];
+
+    for (size_t i = 0; i < 16; i++) {
+        w[i] = (uint32_t) block[i * 4] << 24 | (uint32_t) block[i * 4 + 1] << 16 | (uint32_t) block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    }
+
+    for (size_t i = 16; i < 80; i++) {
+        w[i] = std::rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    auto [a, b, c, d, e] = state;
+
+    for (size_t i = 0; i < 80; i++) {
+        uint32_t f, k;
+
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+
+        uint32_t temp = std::rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = std::rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+std::string sha1Hex(std::string_view data) {
+    std::array<uint32_t, 5> state = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+    auto bytes = reinterpret_cast<const uint8_t*>(data.data());
+    size_t full = data.size() / 64 * 64;
+
+    for (size_t i = 0; i < full; i += 64) {
+        processBlock(state, bytes + i);
+    }
+
+    // remaining bytes, the 0x80 terminator and the bit length, padded to one or two blocks
+    uint8_t tail[128] = {};
+    size_t rest = data.size() - full;
+
+    for (size_t i = 0; i < rest; i++) {
+        tail[i] = bytes[full + i];
+    }
+
+    tail[rest] = 0x80;
+
+    size_t tailSize = rest + 1 + 8 <= 64 ? 64 : 128;
+    uint64_t bitLength = (uint64_t) data.size() * 8;
+
+    for (size_t i = 0; i < 8; i++) {
+        tail[tailSize - 1 - i] = (uint8_t) (bitLength >> (i * 8));
+    }
+
+    for (size_t i = 0; i < tailSize; i += 64) {
+        processBlock(state, tail + i);
+    }
+
+    static constexpr char digits[] = "0123456789abcdef";
+
+    std::string out;
+    out.reserve(40);
+
+    for (uint32_t word : state) {
+        for (int shift = 28; shift >= 0; shift -= 4) {
+            out.push_back(digits[(word >> shift) & 0xf]);
+        }
+    }
+
+    return out;
+}
+
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace argon {
+
+// Lowercase hex SHA-1 digest of the data, only used for the checksums that GD servers require
+std::string sha1Hex(std::string_view data);
+
+}
@@ -0,0 +1,215 @@
+#include "SharedTokenTable.hpp"
+#include <utility>
+
+namespace argon {
+
+namespace {
+
+// What `SharedTokenTable::impl` points to, only ever touched by the copy that created the table
+struct TableImpl {
+    TokenIndex index;
+    std::vector<PendingCleanup> cleanups;
+};
+
+}
+
+static TableImpl& implOf(SharedTokenTable* table) {
+    return *static_cast<TableImpl*>(table->impl);
+}
+
+static std::string_view view(SharedStr str) {
+    return std::string_view{str.data, str.size};
+}
+
+static SharedStr share(std::string_view str) {
+    return SharedStr{str.data(), str.size()};
+}
+
+static SharedTokenRecord toRecord(const StoredToken& token) {
+    return SharedTokenRecord {
+        .url = share(token.url),
+        .username = share(token.username),
+        .ident = share(token.ident),
+        .token = share(token.token),
+        .accountId = token.accountId,
+        .userId = token.userId,
+        .issuedAt = token.issuedAt,
+        .expiresAt = token.expiresAt,
+        .validatedAt = token.validatedAt,
+    };
+}
+
+static StoredToken fromRecord(const SharedTokenRecord& record) {
+    return StoredToken {
+        .url = std::string{view(record.url)},
+        .accountId = record.accountId,
+        .userId = record.userId,
+        .username = std::string{view(record.username)},
+        .ident = std::string{view(record.ident)},
+        .token = std::string{view(record.token)},
+        .issuedAt = record.issuedAt,
+        .expiresAt = record.expiresAt,
+        .validatedAt = record.validatedAt,
+    };
+}
+
+static SharedCleanupRecord toRecord(const PendingCleanup& cleanup) {
+    return SharedCleanupRecord {
+        .url = share(cleanup.url),
+        .accountId = cleanup.accountId,
+        .id = cleanup.id,
+        .levelId = cleanup.levelId,
+        .attempts = cleanup.attempts,
+        .notBefore = cleanup.notBefore,
+        .kind = (uint8_t) cleanup.kind,
+    };
+}
+
+static PendingCleanup fromRecord(const SharedCleanupRecord& record) {
+    return PendingCleanup {
+        .url = std::string{view(record.url)},
+        .accountId = record.accountId,
+        .kind = (CleanupKind) record.kind,
+        .id = record.id,
+        .levelId = record.levelId,
+        .attempts = record.attempts,
+        .notBefore = record.notBefore,
+    };
+}
+
+static constexpr SharedTokenTableFns TABLE_FNS = {
+    .find = [](SharedTokenTable* table, SharedStr url, int32_t accountId, int32_t userId, SharedTokenRecord* out) {
+        auto token = std::as_const(implOf(table).index).find(view(url), accountId, userId);
+        if (!token) return false;
+
+        *out = toRecord(*token);
+        return true;
+    },
+
+    .upsert = [](SharedTokenTable* table, const SharedTokenRecord* record) {
+        implOf(table).index.upsert(fromRecord(*record));
+    },
+
+    .eraseAccount = [](SharedTokenTable* table, int32_t accountId, SharedStr url) {
+        return implOf(table).index.eraseAccount(accountId, view(url));
+    },
+
+    .eraseServer = [](SharedTokenTable* table, SharedStr url) {
+        return implOf(table).index.eraseServer(view(url));
+    },
+
+    .assignTokens = [](SharedTokenTable* table, const SharedTokenRecord* records, size_t count) {
+        std::vector<StoredToken> tokens;
+        tokens.reserve(count);
+
+        for (size_t i = 0; i < count; i++) {
+            tokens.push_back(fromRecord(records[i]));
+        }
+
+        implOf(table).index.assign(std::move(tokens));
+    },
+
+    .visitTokens = [](SharedTokenTable* table, void* ctx, void (*visit)(void*, const SharedTokenRecord*)) {
+        for (auto& token : implOf(table).index.tokens()) {
+            auto record = toRecord(token);
+            visit(ctx, &record);
+        }
+    },
+
+    .assignCleanups = [](SharedTokenTable* table, const SharedCleanupRecord* records, size_t count) {
+        auto& cleanups = implOf(table).cleanups;
+        cleanups.clear();
+        cleanups.reserve(count);
+
+        for (size_t i = 0; i < count; i++) {
+            cleanups.push_back(fromRecord(records[i]));
+        }
+    },
+
+    .visitCleanups = [](SharedTokenTable* table, void* ctx, void (*visit)(void*, const SharedCleanupRecord*)) {
+        for (auto& cleanup : implOf(table).cleanups) {
+            auto record = toRecord(cleanup);
+            visit(ctx, &record);
+        }
+    },
+};
+
+SharedTokenTable::SharedTokenTable() : fns(&TABLE_FNS), impl(new TableImpl{}) {}
+
+SharedFileStamp toSharedStamp(const FileStamp& stamp) {
+    return SharedFileStamp {
+        .mtime = (int64_t) stamp.mtime.time_since_epoch().count(),
+        .size = (uint64_t) stamp.size,
+        .exists = stamp.exists,
+    };
+}
+
+bool operator==(const SharedFileStamp& a, const SharedFileStamp& b) {
+    return a.mtime == b.mtime && a.size == b.size && a.exists == b.exists;
+}
+
+std::optional<StoredToken> TokenTable::find(std::string_view url, int accountId, int userId) const {
+    SharedTokenRecord record;
+    if (!m_shared.fns->find(&m_shared, share(url), accountId, userId, &record)) {
+        return std::nullopt;
+    }
+
+    return fromRecord(record);
+}
+
+void TokenTable::upsert(const StoredToken& token) {
+    auto record = toRecord(token);
+    m_shared.fns->upsert(&m_shared, &record);
+}
+
+size_t TokenTable::eraseAccount(int accountId, std::string_view url) {
+    return m_shared.fns->eraseAccount(&m_shared, accountId, share(url));
+}
+
+size_t TokenTable::eraseServer(std::string_view url) {
+    return m_shared.fns->eraseServer(&m_shared, share(url));
+}
+
+std::vector<StoredToken> TokenTable::tokens() const {
+    std::vector<StoredToken> out;
+
+    m_shared.fns->visitTokens(&m_shared, &out, [](void* ctx, const SharedTokenRecord* record) {
+        static_cast<std::vector<StoredToken>*>(ctx)->push_back(fromRecord(*record));
+    });
+
+    return out;
+}
+
+void TokenTable::assignTokens(const std::vector<StoredToken>& tokens) {
+    std::vector<SharedTokenRecord> records;
+    records.reserve(tokens.size());
+
+    for (auto& token : tokens) {
+        records.push_back(toRecord(token));
+    }
+
+    m_shared.fns->assignTokens(&m_shared, records.data(), records.size());
+}
+
+std::vector<PendingCleanup> TokenTable::cleanups() const {
+    std::vector<PendingCleanup> out;
+
+    m_shared.fns->visitCleanups(&m_shared, &out, [](void* ctx, const SharedCleanupRecord* record) {
+        static_cast<std::vector<PendingCleanup>*>(ctx)->push_back(fromRecord(*record));
+    });
+
+    return out;
+}
+
+void TokenTable::assignCleanups(const std::vector<PendingCleanup>& cleanups) {
+    std::vector<SharedCleanupRecord> records;
+    records.reserve(cleanups.size());
+
+    for (auto& cleanup : cleanups) {
+        records.push_back(toRecord(cleanup));
+    }
+
+    m_shared.fns->assignCleanups(&m_shared, records.data(), records.size());
+}
+
+}
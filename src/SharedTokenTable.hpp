@@ -0,0 +1,144 @@
+#pragma once
+
+#include "TokenIndex.hpp"
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace argon {
+
+// The structs in this file are shared between copies of Argon that may have been built with different compilers
+// and standard libraries, so they only contain C types. Any change to their layout must bump `SharedTokenTable::VERSION`
+// and the key the table is stored under.
+
+// Borrowed string. Strings passed to the table are only used during the call, strings handed out by it
+// stay valid until the table is modified or the config lock is released.
+struct SharedStr {
+    const char* data;
+    size_t size;
+};
+
+struct SharedTokenRecord {
+    SharedStr url;
+    SharedStr username;
+    SharedStr ident;
+    SharedStr token;
+    int32_t accountId;
+    int32_t userId;
+    int64_t issuedAt;
+    int64_t expiresAt;
+    int64_t validatedAt;
+};
+
+struct SharedCleanupRecord {
+    SharedStr url;
+    int32_t accountId;
+    int32_t id;
+    int32_t levelId;
+    uint32_t attempts;
+    int64_t notBefore;
+    uint8_t kind;
+    uint8_t reserved[7]{};
+};
+
+struct SharedFileStamp {
+    // `file_time_type` ticks, which may mean something different to each copy. The worst a mismatch can do is an extra reload.
+    int64_t mtime;
+    uint64_t size;
+    uint8_t exists;
+    uint8_t reserved[7]{};
+};
+
+struct SharedTokenTable;
+
+// Implemented by the copy of Argon that created the table, the only one that knows what `impl` points to.
+// Must only be called with the config lock held.
+struct SharedTokenTableFns {
+    // Returns false if there is no such token
+    bool (*find)(SharedTokenTable* table, SharedStr url, int32_t accountId, int32_t userId, SharedTokenRecord* out);
+    void (*upsert)(SharedTokenTable* table, const SharedTokenRecord* record);
+    // Both return the amount of removed tokens
+    size_t (*eraseAccount)(SharedTokenTable* table, int32_t accountId, SharedStr url);
+    size_t (*eraseServer)(SharedTokenTable* table, SharedStr url);
+    // Replaces every token
+    void (*assignTokens)(SharedTokenTable* table, const SharedTokenRecord* records, size_t count);
+    void (*visitTokens)(SharedTokenTable* table, void* ctx, void (*visit)(void* ctx, const SharedTokenRecord* record));
+    // Replaces every cleanup
+    void (*assignCleanups)(SharedTokenTable* table, const SharedCleanupRecord* records, size_t count);
+    void (*visitCleanups)(SharedTokenTable* table, void* ctx, void (*visit)(void* ctx, const SharedCleanupRecord* record));
+};
+
+// Token table shared between every copy of Argon loaded into the game, published as a GameManager user object.
+// The tokens themselves live in the creator's memory and are only reached through `fns`, everything else
+// is plain data that any copy may read and write. Only ever accessed with the config lock held.
+struct SharedTokenTable {
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t version = VERSION;
+    // `sizeof` this struct in the copy that created it
+    uint32_t size = sizeof(SharedTokenTable);
+    const SharedTokenTableFns* fns;
+    void* impl;
+
+    // The `_ver` field of the data file, incremented on every change
+    uint64_t generation = 0;
+    // Generation of the newest snapshot that has actually made it to the disk
+    uint64_t writtenGeneration = 0;
+    // Stamp of the data file at the time it was last read or written by any copy
+    SharedFileStamp stamp{};
+    // Whether the table was ever populated from the data file
+    uint8_t loaded = 0;
+    // Whether the compact binary data file is written alongside the JSON one
+    uint8_t binaryStorage = 0;
+    uint8_t reserved[6]{};
+
+    // Only ever runs in the copy that creates the table, the storage behind `impl` is never freed
+    SharedTokenTable();
+};
+
+// Any of these failing means the shared layout has changed, which needs a new `VERSION` and a new key in `ArgonState::initConfigLock`.
+static_assert(SharedTokenTable::VERSION == 1);
+static_assert(std::is_standard_layout_v<SharedTokenTable> && std::is_standard_layout_v<SharedTokenRecord>);
+static_assert(std::is_trivially_copyable_v<SharedTokenRecord> && std::is_trivially_copyable_v<SharedCleanupRecord>);
+#if SIZE_MAX == UINT64_MAX
+static_assert(sizeof(SharedStr) == 16);
+static_assert(sizeof(SharedTokenRecord) == 96 && offsetof(SharedTokenRecord, accountId) == 64);
+static_assert(sizeof(SharedCleanupRecord) == 48 && offsetof(SharedCleanupRecord, kind) == 40);
+static_assert(sizeof(SharedFileStamp) == 24);
+static_assert(sizeof(SharedTokenTableFns) == 8 * sizeof(void*));
+static_assert(sizeof(SharedTokenTable) == 72 && offsetof(SharedTokenTable, stamp) == 40 && offsetof(SharedTokenTable, loaded) == 64);
+#endif
+
+SharedFileStamp toSharedStamp(const FileStamp& stamp);
+bool operator==(const SharedFileStamp& a, const SharedFileStamp& b);
+
+// Typed view of a shared table, converting between the C records and the types the rest of Argon uses
+class TokenTable {
+public:
+    explicit TokenTable(SharedTokenTable& shared) : m_shared(shared) {}
+
+    std::optional<StoredToken> find(std::string_view url, int accountId, int userId) const;
+    // Inserts the token, or replaces the existing one with the same url, account ID and user ID
+    void upsert(const StoredToken& token);
+    size_t eraseAccount(int accountId, std::string_view url);
+    size_t eraseServer(std::string_view url);
+
+    std::vector<StoredToken> tokens() const;
+    void assignTokens(const std::vector<StoredToken>& tokens);
+
+    // Messages and comments that still have to be deleted, stored in the same file as the tokens
+    std::vector<PendingCleanup> cleanups() const;
+    void assignCleanups(const std::vector<PendingCleanup>& cleanups);
+
+    SharedTokenTable* operator->() const {
+        return &m_shared;
+    }
+
+private:
+    SharedTokenTable& m_shared;
+};
+
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <argon/core/TokenIndex.hpp>
+
+namespace argon {
+
+using core::StoredToken;
+using core::CleanupKind;
+using core::PendingCleanup;
+using core::FileStamp;
+using core::TokenIndex;
+
+}
@@ -0,0 +1,138 @@
+#include "Tracing.hpp"
+#include "Web.hpp"
+
+#include <cmath>
+
+using enum std::memory_order;
+
+namespace argon {
+
+size_t LatencyHistogram::bucketFor(uint64_t ms) {
+    if (ms < 1) return 0;
+
+    // bucket = 4 * log2(ms), rounded up, so that the bucket's upper bound is never below the value
+    size_t bucket = (size_t) std::ceil(std::log2((double) ms) * 4.0);
+    return std::min(bucket, BUCKETS - 1);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t bucket) {
+    return (uint64_t) std::llround(std::exp2((double) bucket / 4.0));
+}
+
+void LatencyHistogram::record(std::chrono::milliseconds duration, bool success) {
+    uint64_t ms = std::max<int64_t>(duration.count(), 0);
+
+    m_buckets[bucketFor(ms)].fetch_add(1, relaxed);
+
+    if (!success) {
+        m_failures.fetch_add(1, relaxed);
+    }
+
+    uint64_t prevMax = m_maxMs.load(relaxed);
+    while (ms > prevMax && !m_maxMs.compare_exchange_weak(prevMax, ms, relaxed)) {}
+}
+
+AuthStageStats LatencyHistogram::stats() const {
+    std::array<uint64_t, BUCKETS> buckets;
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < BUCKETS; i++) {
+        buckets[i] = m_buckets[i].load(relaxed);
+        total += buckets[i];
+    }
+
+    uint64_t maxMs = m_maxMs.load(relaxed);
+
+    auto percentile = [&](double p) -> std::chrono::milliseconds {
+        if (total == 0) return std::chrono::milliseconds{0};
+
+        uint64_t rank = std::max<uint64_t>((uint64_t) std::ceil(p * total), 1);
+        uint64_t seen = 0;
+
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return std::chrono::milliseconds(std::min(bucketUpperBound(i), maxMs));
+            }
+        }
+
+        return std::chrono::milliseconds(maxMs);
+    };
+
+    return AuthStageStats {
+        .count = total,
+        .failures = m_failures.load(relaxed),
+        .p50 = percentile(0.5),
+        .p90 = percentile(0.9),
+        .p99 = percentile(0.99),
+        .max = std::chrono::milliseconds(maxMs),
+    };
+}
+
+TraceSpan::TraceSpan(AuthStage stage, int accountId) : m_startedAt(std::chrono::steady_clock::now()) {
+    m_span.stage = stage;
+    m_span.accountId = accountId;
+    m_span.start = std::chrono::system_clock::now();
+}
+
+TraceSpan::~TraceSpan() {
+    if (!m_ended) {
+        this->end(false, "Authentication was cancelled");
+    }
+}
+
+void TraceSpan::addRequest(const web::RequestMeta& meta) {
+    m_span.requests += meta.requests;
+    m_span.bytesSent += meta.bytesSent;
+    m_span.bytesReceived += meta.bytesReceived;
+
+    if (meta.requests != 0) {
+        m_span.httpCode = meta.code;
+    }
+}
+
+void TraceSpan::setPollIterations(size_t iterations) {
+    m_span.pollIterations = iterations;
+}
+
+void TraceSpan::addRetry() {
+    m_span.retries++;
+}
+
+void TraceSpan::end(bool success, std::string error) {
+    if (m_ended) return;
+    m_ended = true;
+
+    m_span.end = std::chrono::system_clock::now();
+    m_span.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_startedAt);
+    m_span.success = success;
+    m_span.error = std::move(error);
+
+    Tracer::get().emit(m_span);
+}
+
+void Tracer::setSink(AuthSpanSink sink) {
+    auto lock = m_sink.lock();
+
+    if (sink) {
+        *lock = std::make_shared<AuthSpanSink>(std::move(sink));
+    } else {
+        lock->reset();
+    }
+}
+
+void Tracer::emit(const AuthSpan& span) {
+    m_histograms[(size_t) span.stage].record(span.duration, span.success);
+
+    // don't hold the lock while calling into the sink, it may be slow or try to replace itself
+    auto sink = *m_sink.lock();
+    if (sink) {
+        (*sink)(span);
+    }
+}
+
+AuthStageStats Tracer::stats(AuthStage stage) const {
+    return m_histograms[(size_t) stage].stats();
+}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <argon/argon.hpp>
+#include "util.hpp"
+
+#include <asp/sync/Mutex.hpp>
+#include <array>
+#include <atomic>
+
+namespace argon {
+
+namespace web {
+    struct RequestMeta;
+}
+
+// Lock-free histogram of durations with exponentially growing buckets, 4 buckets per doubling
+class LatencyHistogram {
+public:
+    void record(std::chrono::milliseconds duration, bool success);
+    AuthStageStats stats() const;
+
+private:
+    static constexpr size_t BUCKETS = 72;
+
+    std::array<std::atomic<uint64_t>, BUCKETS> m_buckets{};
+    std::atomic<uint64_t> m_failures{0};
+    std::atomic<uint64_t> m_maxMs{0};
+
+    static size_t bucketFor(uint64_t ms);
+    static uint64_t bucketUpperBound(size_t bucket);
+};
+
+// A stage that is being timed, reported to the tracer once ended.
+// If it's never ended explicitly (e.g. the auth was cancelled), it is reported as failed on destruction.
+class TraceSpan {
+public:
+    TraceSpan(AuthStage stage, int accountId);
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+    ~TraceSpan();
+
+    void addRequest(const web::RequestMeta& meta);
+    void setPollIterations(size_t iterations);
+    void addRetry();
+
+    template <typename T>
+    void end(const geode::Result<T>& result) {
+        if (result) {
+            this->end(true, {});
+        } else {
+            this->end(false, result.unwrapErr());
+        }
+    }
+
+    void end(bool success, std::string error);
+
+private:
+    AuthSpan m_span;
+    std::chrono::steady_clock::time_point m_startedAt;
+    bool m_ended = false;
+};
+
+class Tracer : public SingletonBase<Tracer> {
+public:
+    void setSink(AuthSpanSink sink);
+    void emit(const AuthSpan& span);
+
+    AuthStageStats stats(AuthStage stage) const;
+
+private:
+    friend class SingletonBase;
+
+    static constexpr size_t STAGE_COUNT = (size_t) AuthStage::VerifySolution + 1;
+
+    asp::Mutex<std::shared_ptr<AuthSpanSink>> m_sink;
+    std::array<LatencyHistogram, STAGE_COUNT> m_histograms;
+
+    Tracer() = default;
+};
+
+}
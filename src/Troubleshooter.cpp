@@ -0,0 +1,112 @@
+#include "Troubleshooter.hpp"
+#include "ArgonState.hpp"
+#include "ArgonStorage.hpp"
+#include "RequestScheduler.hpp"
+#include "Web.hpp"
+
+#include <cstdlib>
+
+using namespace geode::prelude;
+
+namespace argon {
+
+// a few minutes are fine, TLS handshakes start failing once it's off by much more
+static constexpr int64_t MAX_CLOCK_SKEW_SECS = 300;
+
+// Runs a check in the background, awaiting the returned handle gives its result
+template <typename T, typename F>
+static auto startProbe(F run) {
+    return arc::spawn([run = std::move(run)](this auto self) -> arc::Future<T> {
+        co_return co_await run();
+    });
+}
+
+static std::optional<AuthDiagnosis> diagnoseServer(const web::ServerProbe& probe, std::string_view name, AuthFailureCause unreachable) {
+    if (probe.serverTime) {
+        int64_t skew = unixTimestamp() - *probe.serverTime;
+
+        if (std::abs(skew) > MAX_CLOCK_SKEW_SECS) {
+            return AuthDiagnosis {
+                .cause = AuthFailureCause::ClockSkew,
+                .message = fmt::format("Your system clock is off by {} minutes, please correct it and try again", std::abs(skew) / 60),
+            };
+        }
+    }
+
+    if (probe.reachable) {
+        return std::nullopt;
+    }
+
+    if (probe.tlsError) {
+        return AuthDiagnosis {
+            .cause = AuthFailureCause::CertificateError,
+            .message = fmt::format("Could not establish a secure connection to the {}: {}", name, probe.error),
+        };
+    }
+
+    return AuthDiagnosis {
+        .cause = unreachable,
+        .message = fmt::format("Could not reach the {}: {}", name, probe.error),
+    };
+}
+
+arc::Future<AuthDiagnosis> runTroubleshooter(AccountData account, Server server) {
+    auto argonUrl = server.makeUrl("");
+
+    auto accountTask = startProbe<Result<web::GDAccountStatus>>([account, server]() -> arc::Future<Result<web::GDAccountStatus>> {
+        co_return co_await web::checkGDAccount(server, account);
+    });
+
+    auto gdTask = startProbe<web::ServerProbe>([url = fmt::format("{}/", account.serverUrl), server] {
+        return web::probeServer(url, server, web::Host::GD);
+    });
+
+    auto argonTask = startProbe<web::ServerProbe>([argonUrl, server] {
+        return web::probeServer(argonUrl, server, web::Host::Argon);
+    });
+
+    // all three run at the same time and every probe has its own timeout, so this is bounded by the slowest one
+    auto status = co_await accountTask;
+    auto gdProbe = co_await gdTask;
+    auto argonProbe = co_await argonTask;
+
+    // a definitive answer from the GD server beats any guess based on connectivity
+    if (status) {
+        switch (status.unwrap()) {
+            case web::GDAccountStatus::InvalidCredentials:
+                co_return AuthDiagnosis {
+                    .cause = AuthFailureCause::InvalidCredentials,
+                    .message = "Invalid account credentials, please try to Refresh Login in account settings",
+                };
+            case web::GDAccountStatus::MessageLimitReached:
+                co_return AuthDiagnosis {
+                    .cause = AuthFailureCause::MessageLimitReached,
+                    .message = "Sent message limit reached, please try deleting some sent messages",
+                };
+            default:
+                break;
+        }
+    }
+
+    if (auto diag = diagnoseServer(gdProbe, fmt::format("GD server ({})", hostOf(account.serverUrl)), AuthFailureCause::GDServerUnreachable)) {
+        co_return std::move(*diag);
+    }
+
+    if (auto diag = diagnoseServer(argonProbe, fmt::format("Argon server ({})", hostOf(argonUrl)), AuthFailureCause::ArgonServerUnreachable)) {
+        co_return std::move(*diag);
+    }
+
+    if (!status) {
+        co_return AuthDiagnosis {
+            .cause = AuthFailureCause::Unknown,
+            .message = status.unwrapErr(),
+        };
+    }
+
+    co_return AuthDiagnosis {
+        .cause = AuthFailureCause::Unknown,
+        .message = "Stage 2 failed due to unknown error, auth and message limit are OK",
+    };
+}
+
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <argon/argon.hpp>
+
+namespace argon {
+
+// Runs all the checks concurrently and picks the most specific cause out of their results
+arc::Future<AuthDiagnosis> runTroubleshooter(AccountData account, Server server);
+
+}
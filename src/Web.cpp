@@ -1,31 +1,25 @@
 #include "ArgonState.hpp"
 #include "WebData.hpp"
 #include "Web.hpp"
+#include "Sha1.hpp"
+#include "ArgonStorage.hpp"
+#include "RequestScheduler.hpp"
+#include <argon/core/GDEncoding.hpp>
 #ifdef GEODE_IS_ANDROID
 #include <Geode/binding/GJMoreGamesLayer.hpp>
 #endif
 #include <Geode/loader/Mod.hpp>
 #include <asp/iter.hpp>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
 
 using namespace arc;
 
 namespace argon::web {
-// TODO: reverse engineer the "encryption" and replace this all with geode base64
-
-static std::string base64Encode(const gd::string& data) {
-    // trust me i did not want to use this but oh well
-    std::string ret = cocos2d::ZipUtils::base64URLEncode(data);
-    ret.resize(strlen(ret.c_str()));
-
-    return ret;
-}
-
-static std::string base64EncodeEnc(const gd::string& data, gd::string key) {
-    std::string ret = ZipUtils::base64EncodeEnc(data, key);
-    ret.resize(strlen(ret.c_str()));
-
-    return ret;
-}
+// Same for every verification message, so it's encoded at compile time
+static constexpr auto MESSAGE_BODY = core::encodeGDConstant("This is a message sent to verify your account, it can be safely deleted.", "14251");
 
 template <int GDVer, size_t Off, size_t Alt>
 struct Offset {
@@ -101,112 +95,179 @@ static const char* platformString() {
 }
 
 
-static std::string getUserAgent() {
-    return fmt::format("argon/v{} ({}, Geode {}, GD {})",
+// none of these change during the lifetime of the game, no point in formatting them for every request
+static const std::string& getUserAgent() {
+    static const std::string ua = fmt::format("argon/v{} ({}, Geode {}, GD {})",
             ARGON_VERSION,
             platformString(),
             Loader::get()->getVersion(),
             Loader::get()->getGameVersion());
+    return ua;
 }
 
-static std::string getReqMod() {
-    auto mod = Mod::get();
-    return fmt::format("{}/{}", mod->getID(), mod->getVersion().toVString());
+static const std::string& getReqMod() {
+    static const std::string reqMod = [] {
+        auto mod = Mod::get();
+        return fmt::format("{}/{}", mod->getID(), mod->getVersion().toVString());
+    }();
+    return reqMod;
 }
 
-static WebRequest baseRequest() {
+static WebRequest baseRequest(const ServerConfig& server) {
     auto& argon = ArgonState::get();
+    argon.counters().argonRequests.fetch_add(1, std::memory_order::relaxed);
+
     return WebRequest()
         .userAgent(getUserAgent())
-        .certVerification(argon.getCertVerification())
-        .timeout(std::chrono::seconds(10));
+        .certVerification(server.certVerification)
+        .timeout(server.timeout);
 }
 
-static WebRequest baseGDRequest() {
+static WebRequest baseGDRequest(const ServerConfig& server) {
     auto& argon = ArgonState::get();
+    argon.counters().gdRequests.fetch_add(1, std::memory_order::relaxed);
+
     return WebRequest()
         .userAgent("")
-        .certVerification(argon.getCertVerification())
+        .certVerification(server.certVerification)
         .timeout(std::chrono::seconds(20));
 }
 
+// Parses an IMF-fixdate as used in the HTTP Date header, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+static std::optional<int64_t> parseHttpDate(std::string_view date) {
+    static constexpr std::string_view months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+    int day, year, hour, minute, second;
+    char month[4] = {};
+    std::string str{date};
+
+    if (std::sscanf(str.c_str(), "%*3s, %d %3s %d %d:%d:%d GMT", &day, month, &year, &hour, &minute, &second) != 6) {
+        return std::nullopt;
+    }
+
+    auto it = std::find(std::begin(months), std::end(months), std::string_view{month});
+    if (it == std::end(months)) {
+        return std::nullopt;
+    }
+
+    auto ymd = std::chrono::year{year} / std::chrono::month{(unsigned) (it - std::begin(months) + 1)} / std::chrono::day{(unsigned) day};
+    if (!ymd.ok()) {
+        return std::nullopt;
+    }
+
+    auto days = std::chrono::sys_days{ymd}.time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::seconds>(days).count() + hour * 3600 + minute * 60 + second;
+}
+
+// Retry-After is either an amount of seconds or an HTTP date
+static std::optional<int64_t> retryAfterSecs(WebResponse& response) {
+    auto header = response.header("Retry-After");
+    if (!header) {
+        return std::nullopt;
+    }
+
+    std::string_view value = *header;
+
+    int64_t secs;
+    auto res = std::from_chars(value.data(), value.data() + value.size(), secs);
+    if (res.ec == std::errc{} && res.ptr == value.data() + value.size()) {
+        return secs;
+    }
+
+    if (auto date = parseHttpDate(value)) {
+        return *date - unixTimestamp();
+    }
+
+    return std::nullopt;
+}
+
+// Every request to a GD server must hold a permit from the scheduler until its response arrives
+static void finishGD(RequestPermit& permit, WebResponse& response) {
+    permit.finish(response.code(), retryAfterSecs(response));
+}
+
+static void recordMeta(RequestMeta* meta, size_t bytesSent, WebResponse& response) {
+    if (!meta) return;
+
+    meta->code = response.code();
+    meta->requests++;
+    meta->bytesSent += bytesSent;
+    meta->bytesReceived += response.data().size();
+}
+
+// Same as `bodyJSON`, but the body is kept around so its size can be recorded
+static WebRequest& jsonBody(WebRequest& req, const std::string& body) {
+    return req
+        .header("Content-Type", "application/json")
+        .bodyString(body);
+}
+
 Result<WebResponse> wrapResponse(std::string_view what, WebResponse response) {
     if (response.ok()) return Ok(std::move(response));
     return Err(wrapError(response, what));
 }
 
-Future<Result<Stage1ResponseData>> startChallenge(const AccountData& account, std::string_view preferredMethod, bool forceStrong) {
-    auto& argon = ArgonState::get();
-
-    auto payload = matjson::makeObject({
-        {"accountId", account.accountId},
-        {"userId", account.userId},
-        {"username", account.username},
-        {"forceStrong", forceStrong},
-        {"reqMod", getReqMod()},
-        {"preferred", preferredMethod}
-    });
-
-    auto response = co_await baseRequest()
-        .bodyJSON(payload)
-        .post(argon.makeUrl("v1/challenge/start"));
-
-    ARC_CO_UNWRAP_INTO(response, wrapResponse("challenge start", std::move(response)));
-    co_return extractData<Stage1ResponseData>(response);
+static core::Account toCoreAccount(const AccountData& account) {
+    return core::Account {
+        .accountId = account.accountId,
+        .userId = account.userId,
+        .username = account.username,
+        .gjp2 = account.gjp2,
+        .serverUrl = account.serverUrl,
+    };
 }
 
-static Future<VerifyResult> verifyChallengeInner(const AccountData& account, uint32_t challengeId, std::string_view solution, std::string path) {
-    auto& argon = ArgonState::get();
+Future<Result<Stage1ResponseData>> startChallenge(const Server& server, const AccountData& account, std::string_view preferredMethod, bool forceStrong, RequestMeta* meta) {
+    auto body = core::encodeChallengeStart(toCoreAccount(account), preferredMethod, forceStrong, getReqMod());
+    auto req = baseRequest(server.config());
 
-    auto payload = matjson::makeObject({
-        {"challengeId", challengeId},
-        {"accountId", account.accountId},
-        {"solution", solution}
-    });
-
-    auto response = co_await baseRequest()
-        .bodyJSON(payload)
-        .post(argon.makeUrl(path));
-    ARC_CO_UNWRAP_INTO(response, wrapResponse("challenge verify", std::move(response)));
-    ARC_CO_UNWRAP_INTO(auto data, extractData<matjson::Value>(response));
-
-    bool verified = data["verified"].asBool().unwrapOr(false);
-    if (verified) {
-        auto authtoken = data["authtoken"].asString().unwrapOrDefault();
-        if (authtoken.empty()) {
-            co_return Err("Malformed server response (missing auth token)");
-        }
+    auto response = co_await jsonBody(req, body)
+        .post(server.makeUrl(core::CHALLENGE_START_PATH));
+    recordMeta(meta, body.size(), response);
 
-        int comment = data["commentId"].asInt().unwrapOrDefault();
-        co_return Ok(SuccessfulVerification {
-            .authtoken = std::move(authtoken),
-            .commentId = comment
-        });
-    }
+    co_return decodeResponse(response, &core::decodeChallengeStart);
+}
+
+static Future<VerifyResult> verifyChallengeInner(const Server& server, const AccountData& account, uint32_t challengeId, std::string_view solution, std::string_view path, RequestMeta* meta) {
+    auto body = core::encodeChallengeVerify(toCoreAccount(account), challengeId, solution);
+    auto req = baseRequest(server.config());
 
-    auto pollAfter = data["pollAfter"].asInt().unwrapOr(1000);
-    co_return Ok(PollLater(pollAfter));
+    auto response = co_await jsonBody(req, body)
+        .post(server.makeUrl(path));
+    recordMeta(meta, body.size(), response);
+
+    co_return decodeResponse(response, &core::decodeChallengeVerify);
 }
 
-Future<VerifyResult> verifyChallenge(const AccountData& account, uint32_t challengeId, std::string_view solution) {
-    return verifyChallengeInner(account, challengeId, solution, "v1/challenge/verify");
+Future<VerifyResult> verifyChallenge(const Server& server, const AccountData& account, uint32_t challengeId, std::string_view solution, RequestMeta* meta) {
+    return verifyChallengeInner(server, account, challengeId, solution, core::CHALLENGE_VERIFY_PATH, meta);
 }
 
-Future<VerifyResult> verifyChallengePoll(const AccountData& account, uint32_t challengeId, std::string_view solution) {
-    return verifyChallengeInner(account, challengeId, solution, "v1/challenge/verifypoll");
+Future<VerifyResult> verifyChallengePoll(const Server& server, const AccountData& account, uint32_t challengeId, std::string_view solution, RequestMeta* meta) {
+    return verifyChallengeInner(server, account, challengeId, solution, core::CHALLENGE_VERIFY_POLL_PATH, meta);
 }
 
-Future<Result<>> submitGDMessage(const AccountData& account, int target, std::string_view message) {
+Future<Result<>> submitGDMessage(const Server& server, const AccountData& account, int target, std::string_view message, RequestMeta* meta) {
     auto payload = fmt::format(
         "accountID={}&gjp2={}&gameVersion=22&binaryVersion=45"
-        "&secret=Wmfd2893gb7&toAccountID={}&subject={}&body={}",
-        account.accountId, account.gjp2, target, base64Encode(gd::string{message.data(), message.size()}),
-        base64EncodeEnc("This is a message sent to verify your account, it can be safely deleted.", "14251")
+        "&secret=Wmfd2893gb7&toAccountID={}&subject=",
+        account.accountId, account.gjp2, target
     );
 
-    auto response = co_await baseGDRequest()
+    payload.reserve(payload.size() + core::gdBase64Size(message.size()) + 6 + MESSAGE_BODY.view().size());
+    core::appendGDBase64(payload, message);
+    payload += "&body=";
+    payload += MESSAGE_BODY.view();
+
+    auto url = fmt::format("{}/uploadGJMessage20.php", account.serverUrl);
+    auto permit = co_await acquireRequestPermit(url, RequestPriority::Interactive);
+
+    auto response = co_await baseGDRequest(server.config())
         .bodyString(payload)
-        .post(fmt::format("{}/uploadGJMessage20.php", account.serverUrl));
+        .post(url);
+    finishGD(permit, response);
+    recordMeta(meta, payload.size(), response);
+
     ARC_CO_UNWRAP_INTO(response, wrapResponse("GD message", std::move(response)));
 
     auto res = response.string().unwrapOrDefault();
@@ -217,37 +278,120 @@ Future<Result<>> submitGDMessage(const AccountData& account, int target, std::st
     co_return Ok();
 }
 
-Future<Result<>> deleteGDMessage(const AccountData& account, int id) {
+static Future<Result<>> deleteGDMessagesInner(const Server& server, const AccountData& account, std::string param) {
     auto payload = fmt::format(
         "accountID={}&gjp2={}&gameVersion=22&binaryVersion=45"
-        "&secret=Wmfd2893gb7&isSender=1&messageID={}",
-        account.accountId, account.gjp2, id
+        "&secret=Wmfd2893gb7&isSender=1&{}",
+        account.accountId, account.gjp2, param
     );
 
+    // cleanup is never urgent, let any authentication go first
+    auto url = fmt::format("{}/deleteGJMessages20.php", account.serverUrl);
+    auto permit = co_await acquireRequestPermit(url, RequestPriority::Background);
+
     // delete the message
-    auto response = co_await baseGDRequest()
+    auto response = co_await baseGDRequest(server.config())
         .bodyString(payload)
-        .post(fmt::format("{}/deleteGJMessages20.php", account.serverUrl));
+        .post(url);
+    finishGD(permit, response);
 
     ARC_CO_UNWRAP_INTO(response, wrapResponse("delete GD message", std::move(response)));
 
+    if (response.string().unwrapOrDefault() == "-1") {
+        co_return Err(wrapError(response, "delete GD message"));
+    }
+
     co_return Ok();
 }
 
-Future<Result<>> submitGDComment(const AccountData& account, int target, std::string_view message) {
-    co_return Err("Comment auth not yet implemented");
+Future<Result<>> deleteGDMessage(const Server& server, const AccountData& account, int id) {
+    return deleteGDMessagesInner(server, account, fmt::format("messageID={}", id));
 }
 
-Future<Result<>> checkGDMessageLimit(const AccountData& account) {
+Future<Result<>> deleteGDMessages(const Server& server, const AccountData& account, std::span<const int> ids) {
+    if (ids.size() == 1) {
+        return deleteGDMessage(server, account, ids[0]);
+    }
+
+    std::string param = "messages=";
+
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (i != 0) param.push_back(',');
+        param += fmt::to_string(ids[i]);
+    }
+
+    return deleteGDMessagesInner(server, account, std::move(param));
+}
+
+Future<Result<>> submitGDComment(const Server& server, const AccountData& account, int levelId, std::string_view message, RequestMeta* meta) {
+    std::string comment;
+    core::appendGDBase64(comment, message);
+
+    // level comments need a checksum of the username, comment, level ID, percentage and comment type
+    std::string chk;
+    core::appendGDBase64(chk, sha1Hex(fmt::format("{}{}{}00xPT6iUrtws0J", account.username, comment, levelId)), "29481");
+
+    auto payload = fmt::format(
+        "accountID={}&gjp2={}&gameVersion=22&binaryVersion=45"
+        "&secret=Wmfd2893gb7&userName={}&comment={}&levelID={}&percent=0&chk={}",
+        account.accountId, account.gjp2, account.username, comment, levelId, chk
+    );
+
+    auto url = fmt::format("{}/uploadGJComment21.php", account.serverUrl);
+    auto permit = co_await acquireRequestPermit(url, RequestPriority::Interactive);
+
+    auto response = co_await baseGDRequest(server.config())
+        .bodyString(payload)
+        .post(url);
+    finishGD(permit, response);
+    recordMeta(meta, payload.size(), response);
+
+    ARC_CO_UNWRAP_INTO(response, wrapResponse("GD comment", std::move(response)));
+
+    // on success the response is the comment ID, anything negative is an error (e.g. -10 if comment banned)
+    auto res = response.string().unwrapOrDefault();
+    if (res.empty() || res.starts_with('-') || res.starts_with("temp")) {
+        co_return Err(wrapError(response, "GD comment"));
+    }
+
+    co_return Ok();
+}
+
+Future<Result<>> deleteGDComment(const Server& server, const AccountData& account, int levelId, int id) {
+    auto payload = fmt::format(
+        "accountID={}&gjp2={}&gameVersion=22&binaryVersion=45"
+        "&secret=Wmfd2893gb7&commentID={}&levelID={}",
+        account.accountId, account.gjp2, id, levelId
+    );
+
+    auto url = fmt::format("{}/deleteGJComment20.php", account.serverUrl);
+    auto permit = co_await acquireRequestPermit(url, RequestPriority::Background);
+
+    auto response = co_await baseGDRequest(server.config())
+        .bodyString(payload)
+        .post(url);
+    finishGD(permit, response);
+
+    ARC_CO_UNWRAP_INTO(response, wrapResponse("delete GD comment", std::move(response)));
+
+    co_return Ok();
+}
+
+Future<Result<GDAccountStatus>> checkGDAccount(const Server& server, const AccountData& account, RequestMeta* meta) {
     auto payload = fmt::format(
         "accountID={}&gjp2={}&gameVersion=22&binaryVersion=45"
         "&secret=Wmfd2893gb7&count=50&page=7&getSent=1",
         account.accountId, account.gjp2
     );
 
-    auto response = co_await baseGDRequest()
+    auto url = fmt::format("{}/getGJMessages20.php", account.serverUrl);
+    auto permit = co_await acquireRequestPermit(url, RequestPriority::Interactive);
+
+    auto response = co_await baseGDRequest(server.config())
         .bodyString(payload)
-        .post(fmt::format("{}/getGJMessages20.php", account.serverUrl));
+        .post(url);
+    finishGD(permit, response);
+    recordMeta(meta, payload.size(), response);
 
     ARC_CO_UNWRAP_INTO(response, wrapResponse("fetch GD messages", std::move(response)));
     auto str = response.string().unwrapOrDefault();
@@ -256,7 +400,7 @@ Future<Result<>> checkGDMessageLimit(const AccountData& account) {
     }
 
     if (str == "-1") {
-        co_return Err("Invalid account credentials, please try to Refresh Login in account settings");
+        co_return Ok(GDAccountStatus::InvalidCredentials);
     }
 
     size_t msgCount = 0;
@@ -264,11 +408,61 @@ Future<Result<>> checkGDMessageLimit(const AccountData& account) {
         msgCount = asp::iter::split(str, '|').count();
     }
 
-    if (msgCount == 50) {
-        co_return Err("Sent message limit reached, please try deleting some sent messages");
+    co_return Ok(msgCount == 50 ? GDAccountStatus::MessageLimitReached : GDAccountStatus::Ok);
+}
+
+Future<ServerProbe> probeServer(std::string url, Server server, Host host) {
+    std::optional<RequestPermit> permit;
+    if (host == Host::GD) {
+        permit.emplace(co_await acquireRequestPermit(url, RequestPriority::Interactive));
     }
 
-    co_return Ok();
+    auto response = co_await (host == Host::Argon ? baseRequest(server.config()) : baseGDRequest(server.config()))
+        .timeout(std::chrono::seconds(5))
+        .get(url);
+
+    if (permit) {
+        finishGD(*permit, response);
+    }
+
+    ServerProbe probe;
+
+    if (response.code() == -1) {
+        probe.error = response.errorMessage();
+        if (probe.error.empty()) {
+            probe.error = "unknown error";
+        }
+
+        // curl reports all of these as "SSL certificate problem: ..." or "SSL connect error"
+        probe.tlsError = probe.error.find("SSL") != std::string::npos || probe.error.find("certificate") != std::string::npos;
+        co_return probe;
+    }
+
+    probe.reachable = true;
+
+    if (auto date = response.header("Date")) {
+        probe.serverTime = parseHttpDate(*date);
+    }
+
+    co_return probe;
 }
 
-}
\ No newline at end of file
+Future<> prewarmConnection(std::string url, Server server, Host host) {
+    std::optional<RequestPermit> permit;
+    if (host == Host::GD) {
+        permit.emplace(co_await acquireRequestPermit(url, RequestPriority::Background));
+    }
+
+    // the response itself is irrelevant, anything the web client caches along the way is a bonus
+    auto response = co_await (host == Host::Argon ? baseRequest(server.config()) : baseGDRequest(server.config()))
+        .timeout(std::chrono::seconds(5))
+        .get(url);
+
+    if (permit) {
+        finishGD(*permit, response);
+    }
+
+    log::debug("(Argon) Warm-up request to {} finished (code {})", url, response.code());
+}
+
+}
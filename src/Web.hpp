@@ -2,29 +2,67 @@
 #include <argon/argon.hpp>
 #include <Geode/utils/web.hpp>
 #include "WebData.hpp"
+#include <span>
 
 namespace argon::web {
 
 std::string getBaseServerUrl();
 
-struct SuccessfulVerification {
-    std::string authtoken;
-    int commentId;
+using SuccessfulVerification = core::Verification;
+using PollLater = core::PollLater;
+
+// Details about the requests made by a web function, filled in if a pointer to it is passed
+struct RequestMeta {
+    // status code of the last response, -1 if there was none
+    int code = -1;
+    size_t requests = 0;
+    size_t bytesSent = 0;
+    size_t bytesReceived = 0;
 };
 
-struct PollLater {
-    uint32_t ms;
+using VerifyData = core::VerifyOutcome;
+using VerifyResult = geode::Result<VerifyData>;
+
+arc::Future<geode::Result<Stage1ResponseData>> startChallenge(const Server& server, const AccountData& account, std::string_view preferredMethod, bool forceStrong, RequestMeta* meta = nullptr);
+arc::Future<VerifyResult> verifyChallenge(const Server& server, const AccountData& account, uint32_t challengeId, std::string_view solution, RequestMeta* meta = nullptr);
+arc::Future<VerifyResult> verifyChallengePoll(const Server& server, const AccountData& account, uint32_t challengeId, std::string_view solution, RequestMeta* meta = nullptr);
+
+// GD requests go to `account.serverUrl`, `server` is the Argon server they are made for and decides their settings (e.g. cert verification)
+arc::Future<geode::Result<>> submitGDMessage(const Server& server, const AccountData& account, int target, std::string_view message, RequestMeta* meta = nullptr);
+arc::Future<geode::Result<>> deleteGDMessage(const Server& server, const AccountData& account, int id);
+// Deletes multiple sent messages in one request, not every GD server supports this
+arc::Future<geode::Result<>> deleteGDMessages(const Server& server, const AccountData& account, std::span<const int> ids);
+// Posts a comment on the given level
+arc::Future<geode::Result<>> submitGDComment(const Server& server, const AccountData& account, int levelId, std::string_view message, RequestMeta* meta = nullptr);
+arc::Future<geode::Result<>> deleteGDComment(const Server& server, const AccountData& account, int levelId, int id);
+enum class GDAccountStatus {
+    Ok,
+    InvalidCredentials,
+    // The account has sent so many messages that it can't send any more
+    MessageLimitReached,
 };
 
-using VerifyResult = geode::Result<std::variant<SuccessfulVerification, PollLater>>;
+arc::Future<geode::Result<GDAccountStatus>> checkGDAccount(const Server& server, const AccountData& account, RequestMeta* meta = nullptr);
+
+struct ServerProbe {
+    // Whether any HTTP response was received, regardless of the status code
+    bool reachable = false;
+    bool tlsError = false;
+    std::string error;
+    // Unix timestamp from the Date header of the response
+    std::optional<int64_t> serverTime;
+};
+
+// Which server a URL passed to `probeServer` or `prewarmConnection` belongs to
+enum class Host {
+    Argon,
+    GD,
+};
 
-arc::Future<geode::Result<Stage1ResponseData>> startChallenge(const AccountData& account, std::string_view preferredMethod, bool forceStrong);
-arc::Future<VerifyResult> verifyChallenge(const AccountData& account, uint32_t challengeId, std::string_view solution);
-arc::Future<VerifyResult> verifyChallengePoll(const AccountData& account, uint32_t challengeId, std::string_view solution);
+// Makes a cheap request to the given URL, to check whether the server can be reached at all
+arc::Future<ServerProbe> probeServer(std::string url, Server server, Host host);
 
-arc::Future<geode::Result<>> submitGDMessage(const AccountData& account, int target, std::string_view message);
-arc::Future<geode::Result<>> deleteGDMessage(const AccountData& account, int id);
-arc::Future<geode::Result<>> submitGDComment(const AccountData& account, int target, std::string_view message);
-arc::Future<geode::Result<>> checkGDMessageLimit(const AccountData& account);
+// Makes a throwaway request to the given URL, in the hope that DNS results or TLS sessions get cached. Keeps no connection open.
+arc::Future<> prewarmConnection(std::string url, Server server, Host host);
 
 }